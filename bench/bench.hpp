@@ -0,0 +1,169 @@
+#pragma once
+
+/**
+ * @file
+ *
+ * Minimal timing helpers for the benchmarks
+ *
+ * Each benchmark is a standalone program. Build with optimisations from the
+ * repository root, e.g.
+ *
+ *     c++ -std=c++11 -O2 -I. bench/lifecycle.cpp -o lifecycle
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace bench {
+
+using clock = std::chrono::steady_clock;
+
+// written to so that results are not optimised away
+static volatile std::size_t sink = 0;
+
+template <typename T>
+void keep(const T& val)
+{
+	sink = sink + static_cast<std::size_t>(val);
+}
+
+// run setup then fn `reps' times, and report the fastest run of fn
+// setup is not timed
+template <typename Setup, typename F>
+double run(const char* name, int reps, Setup setup, F fn)
+{
+	double best = 0;
+	for(int i = 0; i < reps; ++i) {
+		setup();
+
+		auto start = clock::now();
+		fn();
+		auto end = clock::now();
+
+		double us = std::chrono::duration<double, std::micro>(end - start).count();
+		if(i == 0 || us < best) {
+			best = us;
+		}
+	}
+
+	std::printf("%-48s %12.2f us\n", name, best);
+	return best;
+}
+
+template <typename F>
+double run(const char* name, int reps, F fn)
+{
+	return run(name, reps, [] {}, fn);
+}
+
+// latency histogram, in the style of HdrHistogram
+//
+// values below 2^(sub_bits + 1) get a bucket each, and each power of two
+// above that is split into 2^sub_bits buckets, so a recorded value is off by
+// less than 1% while a few thousand buckets cover any uint64_t
+class histogram
+{
+private:
+
+	static const int sub_bits = 7;
+	static const std::uint64_t sub_count = std::uint64_t(1) << sub_bits;
+
+	std::vector<std::uint64_t> counts;
+	std::uint64_t total;
+	std::uint64_t max_val;
+
+	static std::size_t bucket_of(std::uint64_t val)
+	{
+		std::size_t shift = 0;
+		while(val >= 2 * sub_count) {
+			val >>= 1;
+			++shift;
+		}
+		return static_cast<std::size_t>((shift << sub_bits) + val);
+	}
+
+	// highest value which falls in the bucket
+	static std::uint64_t value_of(std::size_t bucket)
+	{
+		if(bucket < 2 * sub_count) {
+			return bucket;
+		}
+		std::size_t shift = (bucket >> sub_bits) - 1;
+		std::uint64_t val = bucket - (shift << sub_bits);
+		return ((val + 1) << shift) - 1;
+	}
+
+public:
+
+	histogram()
+		: counts(bucket_of(~std::uint64_t(0)) + 1), total(0), max_val(0)
+	{
+	}
+
+	void record(std::uint64_t val)
+	{
+		++counts[bucket_of(val)];
+		++total;
+		if(val > max_val) {
+			max_val = val;
+		}
+	}
+
+	// record the time since `start', in nanoseconds
+	void record_since(clock::time_point start)
+	{
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+		this->record(static_cast<std::uint64_t>(ns));
+	}
+
+	std::uint64_t count() const
+	{
+		return total;
+	}
+
+	std::uint64_t max() const
+	{
+		return max_val;
+	}
+
+	// smallest value which at least `p' (0 to 1) of the values are at or below
+	std::uint64_t percentile(double p) const
+	{
+		auto want = static_cast<std::uint64_t>(p * static_cast<double>(total) + 0.5);
+		if(want == 0) {
+			want = 1;
+		}
+
+		std::uint64_t seen = 0;
+		for(std::size_t i = 0; i < counts.size(); ++i) {
+			seen += counts[i];
+			if(seen >= want) {
+				auto val = value_of(i);
+				return val < max_val ? val : max_val;
+			}
+		}
+		return max_val;
+	}
+
+	void clear()
+	{
+		std::fill(counts.begin(), counts.end(), 0);
+		total = max_val = 0;
+	}
+
+	// print p50/p99/p99.9/max, in nanoseconds
+	void print(const char* name) const
+	{
+		std::printf("%-48s p50 %8llu  p99 %8llu  p99.9 %8llu  max %10llu ns\n", name,
+		            static_cast<unsigned long long>(this->percentile(0.5)),
+		            static_cast<unsigned long long>(this->percentile(0.99)),
+		            static_cast<unsigned long long>(this->percentile(0.999)),
+		            static_cast<unsigned long long>(max_val));
+	}
+};
+
+} // namespace bench
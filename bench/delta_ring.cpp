@@ -0,0 +1,60 @@
+#include "include/delta_ring.hpp"
+#include "include/ring_buffer.hpp"
+
+/*
+ * memory and read throughput of a delta_ring against ring_buffer<int64_t>,
+ * for a day of per second samples of a slowly varying gauge
+ */
+
+#include <cstdint>
+#include <cstdio>
+
+#include "bench.hpp"
+
+namespace {
+
+const std::size_t count = 86400;
+const int reps = 20;
+
+} // namespace
+
+int main()
+{
+	ring_buffer<std::int64_t> plain;
+	delta_ring<> packed;
+
+	std::int64_t level = 1000000;
+	for(std::size_t i = 0; i < count; ++i) {
+		level += static_cast<std::int64_t>(i * 2654435761u % 201) - 100;
+		plain.push_back(level);
+		packed.push_back(level);
+	}
+	plain.shrink_to_fit();
+	packed.shrink_to_fit();
+
+	std::printf("ring_buffer<int64_t>: %zu bytes\n", static_cast<std::size_t>(plain.capacity() * sizeof(std::int64_t)));
+	std::printf("delta_ring<>:         %zu bytes, %zu blocks\n", static_cast<std::size_t>(packed.memory_bytes()),
+	            static_cast<std::size_t>(packed.block_count()));
+
+	bench::run("ring_buffer<int64_t>, sum", reps, [&] {
+		std::int64_t sum = 0;
+		for(auto val : plain) {
+			sum += val;
+		}
+		bench::keep(sum);
+	});
+
+	bench::run("delta_ring, sum with for_each", reps, [&] {
+		std::int64_t sum = 0;
+		packed.for_each([&](std::int64_t val) { sum += val; });
+		bench::keep(sum);
+	});
+
+	bench::run("delta_ring, sum with iterators", reps, [&] {
+		std::int64_t sum = 0;
+		for(auto val : packed) {
+			sum += val;
+		}
+		bench::keep(sum);
+	});
+}
@@ -0,0 +1,148 @@
+#include "include/ring_buffer_io.hpp"
+
+/*
+ * reading from a socket into a byte ring: read into a temporary array then
+ * insert (copy path) vs read_from (one readv into the free space), and the
+ * same for writing out with write_to
+ *
+ * POSIX only, uses a local socketpair
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include <sys/socket.h>
+
+#include "bench.hpp"
+
+namespace {
+
+// kept below the socket buffer size, so a write never blocks
+const std::size_t chunk = 32 * 1024;
+const std::size_t total = std::size_t(1) << 28;
+const int reps = 3;
+
+using C = ring_buffer<char>;
+
+int fds[2];
+std::vector<char> out_data(chunk, 'x');
+
+void send_chunk()
+{
+	const char* data = out_data.data();
+	std::size_t left = chunk;
+	while(left > 0) {
+		auto n = ::write(fds[0], data, left);
+		data += n;
+		left -= static_cast<std::size_t>(n);
+	}
+}
+
+// read one chunk into c with the copy path
+void recv_copy(C& c, char* tmp, std::size_t tmp_size)
+{
+	std::size_t got = 0;
+	while(got < chunk) {
+		auto n = ::read(fds[1], tmp, tmp_size);
+		c.insert(c.end(), tmp, tmp + n);
+		got += static_cast<std::size_t>(n);
+	}
+}
+
+// discard one chunk from the other end
+void drain()
+{
+	static std::vector<char> discard(chunk);
+	std::size_t got = 0;
+	while(got < chunk) {
+		got += static_cast<std::size_t>(::read(fds[1], discard.data(), chunk - got));
+	}
+}
+
+void recv_readv(C& c)
+{
+	std::size_t got = 0;
+	while(got < chunk) {
+		got += static_cast<std::size_t>(read_from(c, fds[1], chunk - got));
+	}
+}
+
+} // namespace
+
+int main()
+{
+	if(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+		std::perror("socketpair");
+		return 1;
+	}
+
+	C c;
+
+	// the consumer takes half a chunk at a time, so the ring wraps
+	auto consume = [&] {
+		if(c.size() > chunk / 2) {
+			c.pop_front_n(c.size() - chunk / 2);
+		}
+	};
+
+	for(std::size_t tmp_size : { std::size_t(4096), chunk }) {
+		std::vector<char> tmp(tmp_size);
+		char name[64];
+		std::snprintf(name, sizeof(name), "read + insert (%zu byte buffer)", tmp_size);
+
+		bench::run(name, reps, [&] { c.release(); c.reserve(2 * chunk); }, [&] {
+			for(std::size_t done = 0; done < total; done += chunk) {
+				send_chunk();
+				recv_copy(c, tmp.data(), tmp.size());
+				consume();
+			}
+			bench::keep(c.size());
+		});
+	}
+
+	bench::run("read_from", reps, [&] { c.release(); c.reserve(2 * chunk); }, [&] {
+		for(std::size_t done = 0; done < total; done += chunk) {
+			send_chunk();
+			recv_readv(c);
+			consume();
+		}
+		bench::keep(c.size());
+	});
+
+	// writing out, and discarded on the other side
+	// the producer tops the ring back up by a chunk each time
+	std::vector<char> tmp(chunk);
+	auto refill = [&] {
+		c.release();
+		c.assign(2 * chunk, 'y');
+		c.pop_front_n(chunk / 2);
+		c.insert(c.end(), chunk / 2, 'y');
+	};
+
+	bench::run("copy out + write", reps, refill, [&] {
+		for(std::size_t done = 0; done < total; done += chunk) {
+			std::copy_n(c.begin(), chunk, tmp.begin());
+			std::size_t left = chunk;
+			while(left > 0) {
+				left -= static_cast<std::size_t>(::write(fds[0], tmp.data() + (chunk - left), left));
+			}
+			c.pop_front_n(chunk);
+			drain();
+			c.insert(c.end(), chunk, 'y');
+		}
+	});
+
+	bench::run("write_to", reps, refill, [&] {
+		for(std::size_t done = 0; done < total; done += chunk) {
+			std::size_t left = chunk;
+			while(left > 0) {
+				left -= static_cast<std::size_t>(write_to(c, fds[0], left));
+			}
+			drain();
+			c.insert(c.end(), chunk, 'y');
+		}
+	});
+
+	return 0;
+}
@@ -0,0 +1,162 @@
+#include "include/work_stealing_ring.hpp"
+
+/*
+ * fork-join parallel fib: each task either splits into fib(n - 1) and
+ * fib(n - 2), or below a cutoff computes its value serially. workers take
+ * from their own work_stealing_ring and steal from others when out of work.
+ * compared against one shared std::deque behind a mutex
+ *
+ * needs threads, e.g. c++ -std=c++11 -O2 -pthread -I. bench/fork_join.cpp
+ */
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+
+namespace {
+
+const int fib_n = 36;
+const int cutoff = 12;
+const int reps = 5;
+
+long fib_serial(int n)
+{
+	return n < 2 ? n : fib_serial(n - 1) + fib_serial(n - 2);
+}
+
+// pending tasks, workers stop when this reaches 0
+std::atomic<long> outstanding;
+std::atomic<long> result;
+
+// run one task, splitting it or computing it serially
+template <typename Push>
+void process(int n, long& sum, Push push)
+{
+	if(n < cutoff) {
+		sum += fib_serial(n);
+		outstanding.fetch_sub(1, std::memory_order_acq_rel);
+	} else {
+		outstanding.fetch_add(1, std::memory_order_relaxed);
+		push(n - 1);
+		push(n - 2);
+	}
+}
+
+void stealing(unsigned threads)
+{
+	std::vector<std::unique_ptr<work_stealing_ring<int>>> rings;
+	for(unsigned i = 0; i < threads; ++i) {
+		rings.emplace_back(new work_stealing_ring<int>());
+	}
+
+	outstanding.store(1);
+	result.store(0);
+	rings[0]->push(fib_n);
+
+	auto worker = [&](unsigned self) {
+		auto& own = *rings[self];
+		auto push = [&](int n) { own.push(n); };
+		unsigned victim = self;
+		long sum = 0;
+
+		while(outstanding.load(std::memory_order_acquire) > 0) {
+			int n;
+			if(own.pop(n)) {
+				process(n, sum, push);
+				continue;
+			}
+
+			victim = (victim + 1) % threads;
+			if(victim != self && rings[victim]->steal(n)) {
+				process(n, sum, push);
+			}
+		}
+		result.fetch_add(sum);
+	};
+
+	std::vector<std::thread> pool;
+	for(unsigned i = 1; i < threads; ++i) {
+		pool.emplace_back(worker, i);
+	}
+	worker(0);
+	for(auto& t : pool) {
+		t.join();
+	}
+}
+
+void shared_queue(unsigned threads)
+{
+	std::deque<int> queue;
+	std::mutex lock;
+
+	outstanding.store(1);
+	result.store(0);
+	queue.push_back(fib_n);
+
+	auto worker = [&] {
+		auto push = [&](int n) {
+			std::lock_guard<std::mutex> guard(lock);
+			queue.push_back(n);
+		};
+		long sum = 0;
+
+		while(outstanding.load(std::memory_order_acquire) > 0) {
+			int n;
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				if(queue.empty()) {
+					continue;
+				}
+				n = queue.back();
+				queue.pop_back();
+			}
+			process(n, sum, push);
+		}
+		result.fetch_add(sum);
+	};
+
+	std::vector<std::thread> pool;
+	for(unsigned i = 1; i < threads; ++i) {
+		pool.emplace_back(worker);
+	}
+	worker();
+	for(auto& t : pool) {
+		t.join();
+	}
+}
+
+} // namespace
+
+int main()
+{
+	auto expected = fib_serial(fib_n);
+	bench::run("serial", reps, [&] { bench::keep(fib_serial(fib_n)); });
+
+	unsigned max_threads = std::thread::hardware_concurrency();
+	if(max_threads == 0) {
+		max_threads = 4;
+	}
+
+	for(unsigned threads = 1; threads <= max_threads; threads *= 2) {
+		char name[64];
+
+		std::snprintf(name, sizeof(name), "work_stealing_ring, %u threads", threads);
+		bench::run(name, reps, [&] { stealing(threads); });
+		if(result.load() != expected) {
+			std::printf("wrong result\n");
+			return 1;
+		}
+
+		std::snprintf(name, sizeof(name), "mutex + deque, %u threads", threads);
+		bench::run(name, reps, [&] { shared_queue(threads); });
+		if(result.load() != expected) {
+			std::printf("wrong result\n");
+			return 1;
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#include "include/incremental_ring_buffer.hpp"
+#include "include/ring_buffer.hpp"
+
+/*
+ * worst-case push_back latency while growing from empty,
+ * ring_buffer (moves everything at once) vs incremental_ring_buffer
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "bench.hpp"
+
+namespace {
+
+const std::size_t count = 1 << 23;
+
+template <typename C>
+void growth(const char* name)
+{
+	std::vector<double> ns(count);
+	C c;
+
+	auto start = bench::clock::now();
+	for(std::size_t i = 0; i < count; ++i) {
+		auto op_start = bench::clock::now();
+		c.push_back(static_cast<int>(i));
+		auto op_end = bench::clock::now();
+
+		ns[i] = std::chrono::duration<double, std::nano>(op_end - op_start).count();
+	}
+	auto end = bench::clock::now();
+	bench::keep(c.size());
+
+	double total_ms = std::chrono::duration<double, std::milli>(end - start).count();
+	std::sort(ns.begin(), ns.end());
+	auto pct = [&](double p) {
+		return ns[static_cast<std::size_t>(p * static_cast<double>(count - 1))];
+	};
+
+	std::printf("%-24s total %8.1f ms  p50 %6.0f ns  p99.9 %8.0f ns  p99.99 %10.0f ns  max %10.0f ns\n",
+	            name, total_ms, pct(0.5), pct(0.999), pct(0.9999), ns.back());
+}
+
+} // namespace
+
+int main()
+{
+	for(int i = 0; i < 2; ++i) {
+		growth<ring_buffer<int>>("ring_buffer");
+		growth<incremental_ring_buffer<int>>("incremental_ring_buffer");
+	}
+}
@@ -0,0 +1,74 @@
+#include "include/ring_buffer.hpp"
+
+/*
+ * bulk lifecycle operations (clear, pop_front_n, resize, assign)
+ * for trivial and non-trivial values
+ */
+
+#include <string>
+
+#include "bench.hpp"
+
+namespace {
+
+const std::size_t count = 1 << 20;
+const int reps = 20;
+
+template <typename T>
+void lifecycle(const char* type, const T& val)
+{
+	using C = ring_buffer<T>;
+	C c;
+	std::string name;
+
+	// start half way through a memblk which holds exactly count, so values
+	// wrap
+	auto refill = [&] {
+		c.clear();
+		c.shrink_to_fit();
+		c.reserve(count);
+		c.resize(count / 2);
+		c.pop_front_n(count / 2);
+		c.assign(count, val);
+	};
+
+	name = std::string(type) + " clear";
+	bench::run(name.c_str(), reps, refill, [&] {
+		c.clear();
+	});
+
+	name = std::string(type) + " pop_front_n";
+	bench::run(name.c_str(), reps, refill, [&] {
+		c.pop_front_n(count);
+	});
+
+	name = std::string(type) + " resize down";
+	bench::run(name.c_str(), reps, refill, [&] {
+		c.resize(0);
+	});
+
+	name = std::string(type) + " resize up";
+	bench::run(name.c_str(), reps, [&] { c.clear(); c.reserve(count); }, [&] {
+		c.resize(count);
+	});
+
+	name = std::string(type) + " resize_for_overwrite up";
+	bench::run(name.c_str(), reps, [&] { c.clear(); c.reserve(count); }, [&] {
+		c.resize_for_overwrite(count);
+	});
+
+	name = std::string(type) + " assign";
+	bench::run(name.c_str(), reps, refill, [&] {
+		c.assign(count, val);
+	});
+
+	bench::keep(c.size());
+}
+
+} // namespace
+
+int main()
+{
+	lifecycle<int>("int", 1);
+	lifecycle<std::string>("string", std::string(4, 'x'));
+}
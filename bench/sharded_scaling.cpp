@@ -0,0 +1,158 @@
+#include "include/sharded_ring.hpp"
+
+/*
+ * producer scaling: each thread pushes timestamped events while a collector
+ * thread drains them. compared against one shared ring_buffer behind a
+ * mutex, from 1 producer up to every available core
+ *
+ * needs threads, e.g. c++ -std=c++11 -O2 -pthread -I. bench/sharded_scaling.cpp
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+
+namespace {
+
+const long per_thread = 1 << 20;
+const std::size_t shard_capacity = 1 << 14;
+const int reps = 3;
+
+struct event
+{
+	std::uint64_t stamp;
+	std::uint64_t payload;
+};
+
+std::uint64_t now()
+{
+	return static_cast<std::uint64_t>(bench::clock::now().time_since_epoch().count());
+}
+
+// run producers, each pushing until its events are all accepted, while a
+// collector drains with collect(), which returns the number drained
+template <typename Push, typename Collect>
+void run_producers(unsigned threads, Push push, Collect collect)
+{
+	std::atomic<unsigned> running(threads);
+
+	std::thread collector([&] {
+		while(running.load(std::memory_order_acquire) > 0) {
+			if(collect() == 0) {
+				std::this_thread::yield();
+			}
+		}
+		collect();
+	});
+
+	std::vector<std::thread> pool;
+	for(unsigned t = 0; t < threads; ++t) {
+		pool.emplace_back([&, t] {
+			for(long i = 0; i < per_thread; ++i) {
+				event ev = { now(), static_cast<std::uint64_t>(t) };
+				while(!push(ev)) {
+					std::this_thread::yield();
+				}
+			}
+			running.fetch_sub(1, std::memory_order_release);
+		});
+	}
+	for(auto& th : pool) {
+		th.join();
+	}
+	collector.join();
+}
+
+void sharded(unsigned threads, bool merged)
+{
+	sharded_ring<event> ring(shard_capacity);
+	long total = 0;
+
+	run_producers(threads,
+		[&](const event& ev) { return ring.push(ev); },
+		[&]() -> long {
+			long n;
+			if(merged) {
+				n = static_cast<long>(ring.collect_merged([](event&& ev) { bench::keep(ev.payload); },
+					[](const event& ev) { return ev.stamp; }));
+			} else {
+				n = static_cast<long>(ring.collect([](event&& ev) { bench::keep(ev.payload); }));
+			}
+			total += n;
+			return n;
+		});
+
+	if(total != per_thread * threads) {
+		std::printf("lost events\n");
+	}
+}
+
+void shared(unsigned threads)
+{
+	ring_buffer<event> ring;
+	ring_buffer<event> batch;
+	std::mutex lock;
+	long total = 0;
+
+	run_producers(threads,
+		[&](const event& ev) {
+			std::lock_guard<std::mutex> guard(lock);
+			if(ring.size() >= shard_capacity * threads) {
+				return false;
+			}
+			ring.push_back(ev);
+			return true;
+		},
+		[&]() -> long {
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				ring.swap(batch);
+			}
+			for(auto& ev : batch) {
+				bench::keep(ev.payload);
+			}
+			long n = static_cast<long>(batch.size());
+			batch.clear();
+			total += n;
+			return n;
+		});
+
+	if(total != per_thread * threads) {
+		std::printf("lost events\n");
+	}
+}
+
+} // namespace
+
+int main()
+{
+	unsigned max_threads = std::thread::hardware_concurrency();
+	if(max_threads == 0) {
+		max_threads = 4;
+	}
+
+	for(unsigned threads = 1;; threads *= 2) {
+		if(threads > max_threads) {
+			threads = max_threads;
+		}
+		char name[64];
+
+		std::snprintf(name, sizeof(name), "sharded_ring, %u producers", threads);
+		bench::run(name, reps, [&] { sharded(threads, false); });
+
+		std::snprintf(name, sizeof(name), "sharded_ring merged, %u producers", threads);
+		bench::run(name, reps, [&] { sharded(threads, true); });
+
+		std::snprintf(name, sizeof(name), "mutex + ring_buffer, %u producers", threads);
+		bench::run(name, reps, [&] { shared(threads); });
+
+		if(threads == max_threads) {
+			break;
+		}
+	}
+}
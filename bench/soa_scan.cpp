@@ -0,0 +1,79 @@
+#include "include/soa_ring_buffer.hpp"
+#include "include/ring_buffer.hpp"
+
+/*
+ * column scan: sum one field of a million tick records, stored as records
+ * in a ring_buffer, or as columns in a soa_ring_buffer scanned through its
+ * two segments. both rings are wrapped, as a long-running ring would be
+ */
+
+#include <cstdint>
+
+#include "bench.hpp"
+
+namespace {
+
+const std::size_t count = 1 << 20;
+const int reps = 20;
+
+struct tick
+{
+	std::uint64_t timestamp;
+	double price;
+	std::int32_t qty;
+	std::uint32_t flags;
+};
+
+template <typename T>
+double sum_run(const T* first, std::size_t n)
+{
+	double sum = 0;
+	for(std::size_t i = 0; i < n; ++i) {
+		sum += first[i];
+	}
+	return sum;
+}
+
+} // namespace
+
+int main()
+{
+	ring_buffer<tick> aos(count);
+	soa_ring_buffer<std::uint64_t, double, std::int32_t, std::uint32_t> soa(count);
+
+	// wrap both halfway round
+	for(std::size_t i = 0; i < count / 2; ++i) {
+		aos.push_back(tick{ i, 0.0, 0, 0 });
+		soa.push_back(std::uint64_t(i), 0.0, std::int32_t(0), std::uint32_t(0));
+	}
+	for(std::size_t i = 0; i < count / 2; ++i) {
+		aos.pop_front();
+		soa.pop_front();
+	}
+	for(std::size_t i = 0; i < count; ++i) {
+		aos.push_back(tick{ i, i * 0.25, std::int32_t(i), 0 });
+		soa.push_back(std::uint64_t(i), i * 0.25, std::int32_t(i), std::uint32_t(0));
+	}
+
+	bench::run("ring_buffer<tick>, sum of price", reps, [&] {
+		double sum = 0;
+		for(const auto& t : aos) {
+			sum += t.price;
+		}
+		bench::keep(sum);
+	});
+
+	bench::run("soa_ring_buffer, sum of price column", reps, [&] {
+		auto one = soa.first_segment<1>();
+		auto two = soa.second_segment<1>();
+		bench::keep(sum_run(one.first, one.second) + sum_run(two.first, two.second));
+	});
+
+	bench::run("soa_ring_buffer, range-for proxies", reps, [&] {
+		double sum = 0;
+		for(auto rec : soa) {
+			sum += std::get<1>(rec);
+		}
+		bench::keep(sum);
+	});
+}
@@ -0,0 +1,152 @@
+#include "include/ring_buffer.hpp"
+
+/*
+ * per-operation latency of push_back, pop_front, emplace_front and insert,
+ * ring_buffer vs std::deque, under three workloads:
+ *
+ * - cold: from a freshly constructed container, so growth is included
+ * - steady: size is kept constant by undoing each operation (untimed)
+ * - grow/shrink: repeatedly fill then empty, calling shrink_to_fit in between
+ *
+ * each operation is timed with steady_clock, so values include a few tens of
+ * nanoseconds of clock overhead, which is the same for both containers
+ */
+
+#include <deque>
+#include <iterator>
+
+#include "bench.hpp"
+
+namespace {
+
+// values per cold run, and size held by the other workloads
+// insert is in the middle, so O(size), and uses smaller sizes
+const std::size_t big = 1 << 20;
+const std::size_t small = 1 << 12;
+const int runs = 8;
+
+// time `op' `count' times, running `between' after each, untimed
+template <typename C, typename Op, typename Between>
+void timed(bench::histogram& h, C& c, std::size_t count, Op op, Between between)
+{
+	for(std::size_t i = 0; i < count; ++i) {
+		auto start = bench::clock::now();
+		op(c, static_cast<int>(i));
+		h.record_since(start);
+
+		between(c);
+	}
+}
+
+template <typename C>
+void fill(C& c, std::size_t count)
+{
+	for(std::size_t i = 0; i < count; ++i) {
+		c.push_back(static_cast<int>(i));
+	}
+}
+
+struct nothing
+{
+	template <typename C>
+	void operator()(C&) const
+	{
+	}
+};
+
+// operation which increases the size by one, and its inverse
+template <typename C, typename Op, typename Undo>
+void measure_grow(const char* cname, const char* oname, std::size_t size, Op op, Undo undo)
+{
+	bench::histogram h;
+	char name[64];
+
+	for(int r = 0; r < runs; ++r) {
+		C c;
+		timed(h, c, size, op, nothing());
+	}
+	std::snprintf(name, sizeof(name), "%s %s cold", cname, oname);
+	h.print(name);
+	h.clear();
+
+	{
+		C c;
+		fill(c, size);
+		timed(h, c, size * runs, op, undo);
+	}
+	std::snprintf(name, sizeof(name), "%s %s steady", cname, oname);
+	h.print(name);
+	h.clear();
+
+	{
+		C c;
+		for(int r = 0; r < runs; ++r) {
+			timed(h, c, size, op, nothing());
+			c.clear();
+			c.shrink_to_fit();
+		}
+	}
+	std::snprintf(name, sizeof(name), "%s %s grow/shrink", cname, oname);
+	h.print(name);
+}
+
+template <typename C>
+void measure_pop_front(const char* cname, std::size_t size)
+{
+	bench::histogram h;
+	char name[64];
+	auto pop = [](C& c, int) { c.pop_front(); };
+
+	for(int r = 0; r < runs; ++r) {
+		C c;
+		fill(c, size);
+		timed(h, c, size, pop, nothing());
+	}
+	std::snprintf(name, sizeof(name), "%s pop_front cold", cname);
+	h.print(name);
+	h.clear();
+
+	{
+		C c;
+		fill(c, size);
+		timed(h, c, size * runs, pop, [](C& c2) { c2.push_back(0); });
+	}
+	std::snprintf(name, sizeof(name), "%s pop_front steady", cname);
+	h.print(name);
+	h.clear();
+
+	{
+		C c;
+		for(int r = 0; r < runs; ++r) {
+			fill(c, size);
+			timed(h, c, size, pop, nothing());
+			c.shrink_to_fit();
+		}
+	}
+	std::snprintf(name, sizeof(name), "%s pop_front grow/shrink", cname);
+	h.print(name);
+}
+
+template <typename C>
+void measure(const char* cname)
+{
+	measure_grow<C>(cname, "push_back", big,
+		[](C& c, int i) { c.push_back(i); },
+		[](C& c) { c.pop_front(); });
+	measure_pop_front<C>(cname, big);
+	measure_grow<C>(cname, "emplace_front", big,
+		[](C& c, int i) { c.emplace_front(i); },
+		[](C& c) { c.pop_back(); });
+	measure_grow<C>(cname, "insert", small,
+		[](C& c, int i) { c.insert(std::next(c.begin(), static_cast<std::ptrdiff_t>(c.size() / 2)), i); },
+		[](C& c) { c.pop_back(); });
+	std::printf("\n");
+}
+
+} // namespace
+
+int main()
+{
+	measure<ring_buffer<int>>("ring_buffer");
+	measure<std::deque<int>>("deque");
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Fixed array of slots which one thread writes while others may be copying
+ * them, for rings which let readers race the writer and throw away torn
+ * copies afterwards (seqlock_ring, broadcast_ring when overwriting).
+ *
+ * A plain copy which races with a write is a data race, even if the copy is
+ * never used. So slots are arrays of atomic words, and values are copied in
+ * and out a word at a time with relaxed atomics: a racing copy is only
+ * torn. Ordering is up to the caller, with fences around the copies.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * template <typename T, typename Allocator = std::allocator<T>>
+ * class atomic_slots
+ * {
+ * public:
+ *
+ *      explicit atomic_slots(size_type count, const allocator_type& alloc = allocator_type());
+ *
+ *      void store(size_type idx, const T& value);
+ *      void load(size_type idx, T& out) const; // may be torn
+ *
+ *      size_type size() const;
+ * };
+ *
+ * \endcode
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+template <typename T, typename Allocator = std::allocator<T>>
+class atomic_slots
+{
+private: // internal statics
+
+	static_assert(std::is_trivially_copyable<T>::value,
+	              "values are copied while they may be written, so must be trivially copyable");
+
+	using atraits = typename std::allocator_traits<Allocator>;
+
+	// the widest word which evenly divides T
+	using word = typename std::conditional<sizeof(T) % sizeof(std::uint64_t) == 0, std::uint64_t,
+	             typename std::conditional<sizeof(T) % sizeof(std::uint32_t) == 0, std::uint32_t,
+	             unsigned char>::type>::type;
+	static constexpr std::size_t slot_words = sizeof(T) / sizeof(word);
+
+	using word_alloc = typename atraits::template rebind_alloc<std::atomic<word>>;
+	using word_traits = std::allocator_traits<word_alloc>;
+
+public: // statics
+
+	using allocator_type = Allocator;
+	using value_type     = T;
+	using size_type      = typename atraits::size_type;
+
+private: // variables
+
+	word_alloc mm; // `memory manager'
+
+	typename word_traits::pointer words;
+	size_type count;
+
+private: // internal methods
+
+	// {{{ internal methods
+
+	size_type word_count() const
+	{
+		return count * slot_words;
+	}
+
+	// }}}
+
+public: // methods
+
+	// slots start zeroed
+	explicit atomic_slots(size_type i_count, const allocator_type& alloc = allocator_type())
+		: mm(alloc), words(nullptr), count(i_count)
+	{
+		words = word_traits::allocate(mm, this->word_count());
+		for(size_type i = 0; i < this->word_count(); ++i) {
+			word_traits::construct(mm, words + i, word());
+		}
+	}
+
+	atomic_slots(const atomic_slots&) = delete;
+	atomic_slots& operator=(const atomic_slots&) = delete;
+
+	~atomic_slots()
+	{
+		for(size_type i = 0; i < this->word_count(); ++i) {
+			word_traits::destroy(mm, words + i);
+		}
+		word_traits::deallocate(mm, words, this->word_count());
+	}
+
+	// write value to slot idx, a word at a time
+	void store(size_type idx, const T& value)
+	{
+		word buf[slot_words];
+		std::memcpy(buf, &value, sizeof(T));
+
+		auto first = words + idx * slot_words;
+		for(std::size_t i = 0; i < slot_words; ++i) {
+			first[i].store(buf[i], std::memory_order_relaxed);
+		}
+	}
+
+	// copy slot idx to out, a word at a time
+	// may be torn if it's being written
+	void load(size_type idx, T& out) const
+	{
+		word buf[slot_words];
+
+		auto first = words + idx * slot_words;
+		for(std::size_t i = 0; i < slot_words; ++i) {
+			buf[i] = first[i].load(std::memory_order_relaxed);
+		}
+		std::memcpy(&out, buf, sizeof(T));
+	}
+
+	size_type size() const
+	{
+		return count;
+	}
+};
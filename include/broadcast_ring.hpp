@@ -0,0 +1,436 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Single producer, multiple consumer broadcast ring, in the style of the
+ * LMAX disruptor.
+ *
+ * Every consumer sees every value. Values are written once into a ring of
+ * preallocated slots, and each consumer only keeps its own read sequence,
+ * so N consumers cost one write and N reads instead of N copies.
+ *
+ * A consumer can depend on other consumers, in which case it only sees a
+ * value once they have all finished with it (a sequence barrier). This
+ * allows pipelines, e.g. persistence then replication, with each stage
+ * reading the same slot.
+ *
+ * When the ring is full, the producer either waits for the slowest consumer
+ * (broadcast_block), or overwrites values it hasn't read yet
+ * (broadcast_overwrite). With overwriting, consumers which fall more than a
+ * ring behind skip ahead, and count the values they lost. Values are copied
+ * out and checked for being overwritten before use, so must be trivially
+ * copyable, and slots are atomic_slots, so a copy which races with a write
+ * is only torn (and skipped), rather than a data race.
+ *
+ * Sequences count values, so value n is in slot n % capacity.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * struct broadcast_block;
+ * struct broadcast_overwrite;
+ *
+ * template <typename T, typename FullPolicy = broadcast_block, typename Allocator = std::allocator<T>>
+ * class broadcast_ring
+ * {
+ * public:
+ *
+ *      class consumer
+ *      {
+ *      public:
+ *              template <typename F> bool try_read(F f);                  // f(const T&)
+ *              template <typename F> size_type read_batch(F f, size_type max);
+ *              sequence_type sequence() const;
+ *              sequence_type lost() const;                                // broadcast_overwrite
+ *      };
+ *
+ *      explicit broadcast_ring(size_type capacity, const allocator_type& alloc = allocator_type());
+ *
+ *      // before publishing
+ *      consumer& add_consumer(std::initializer_list<const consumer*> depends_on = {});
+ *
+ *      // producer thread only
+ *      template <typename F> void publish(F fill); // fill(T&)
+ *      void push(const T& value);
+ *      bool try_push(const T& value);              // broadcast_block, false if full
+ *
+ *      sequence_type published() const;
+ *      size_type capacity() const;
+ * };
+ *
+ * \endcode
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+#include "atomic_slots.hpp"
+#include "cache_padded.hpp"
+#include "ring_buffer.hpp"
+
+// when full, wait for the slowest consumer
+struct broadcast_block
+{
+};
+
+// when full, overwrite values the slowest consumers haven't read
+struct broadcast_overwrite
+{
+};
+
+template <typename T, typename FullPolicy = broadcast_block, typename Allocator = std::allocator<T>>
+class broadcast_ring
+{
+private: // internal statics
+
+	using is_overwrite = std::integral_constant<bool, std::is_same<FullPolicy, broadcast_overwrite>::value>;
+
+	static_assert(is_overwrite::value || std::is_same<FullPolicy, broadcast_block>::value,
+	              "FullPolicy must be broadcast_block or broadcast_overwrite");
+	static_assert(!is_overwrite::value || std::is_trivially_copyable<T>::value,
+	              "overwritten values are copied out while they may be written, so must be trivially copyable");
+
+	// overwritten slots may be copied while they're written
+	using slot_ring = typename std::conditional<is_overwrite::value,
+	                  atomic_slots<T, Allocator>, ring_buffer<T, Allocator>>::type;
+
+public: // statics
+
+	using allocator_type = Allocator;
+	using value_type     = T;
+	using size_type      = typename slot_ring::size_type;
+	using sequence_type  = std::int64_t;
+
+	class consumer
+	{ // {{{ consumer
+	private:
+
+		friend class broadcast_ring;
+
+		broadcast_ring* ring;
+
+		// values read, and so the next value to read
+		cache_padded<std::atomic<sequence_type>> m_seq;
+
+		// consumers which must read a value first
+		ring_buffer<const consumer*> deps;
+
+		// written and read by the owning thread only
+		sequence_type m_lost;
+
+		// highest sequence known to be readable, to avoid rechecking
+		sequence_type m_avail;
+
+		// update m_avail, returns the number readable
+		sequence_type available()
+		{
+			if(m_avail > m_seq.val.load(std::memory_order_relaxed)) {
+				return m_avail - m_seq.val.load(std::memory_order_relaxed);
+			}
+
+			auto avail = ring->m_published.val.load(std::memory_order_acquire);
+			for(auto dep : deps) {
+				auto dep_seq = dep->m_seq.val.load(std::memory_order_acquire);
+				avail = dep_seq < avail ? dep_seq : avail;
+			}
+			m_avail = avail;
+			return avail - m_seq.val.load(std::memory_order_relaxed);
+		}
+
+		// tag dispatch
+		template <typename F>
+		bool read_one(sequence_type seq, F& f, std::false_type /* overwrite */)
+		{
+			f(static_cast<const T&>(ring->slot(seq)));
+			return true;
+		}
+
+		// copy out, then check it wasn't overwritten while copying
+		template <typename F>
+		bool read_one(sequence_type seq, F& f, std::true_type /* overwrite */)
+		{
+			T copy;
+			ring->slots.load(ring->slot_of(seq), copy);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if(ring->m_claimed.val.load(std::memory_order_relaxed) - seq > ring->cap_signed()) {
+				return false;
+			}
+			f(static_cast<const T&>(copy));
+			return true;
+		}
+
+		// skip ahead if lapped by the producer
+		void catch_up(std::false_type /* overwrite */)
+		{
+		}
+
+		void catch_up(std::true_type /* overwrite */)
+		{
+			auto seq = m_seq.val.load(std::memory_order_relaxed);
+			// a value being written is also lost, so leave a slot spare
+			auto oldest = ring->m_claimed.val.load(std::memory_order_acquire) - ring->cap_signed() + 1;
+			if(seq < oldest) {
+				m_lost += oldest - seq;
+				m_seq.val.store(oldest, std::memory_order_release);
+				m_avail = 0;
+			}
+		}
+
+	public:
+
+		explicit consumer(broadcast_ring* i_ring)
+			: ring(i_ring), m_lost(0), m_avail(0)
+		{
+			m_seq.val.store(0, std::memory_order_relaxed);
+		}
+
+		consumer(const consumer&) = delete;
+		consumer& operator=(const consumer&) = delete;
+
+		// read the next value with f(const T&), false if none is readable
+		template <typename F>
+		bool try_read(F f)
+		{
+			return this->read_batch(f, 1) == 1;
+		}
+
+		// read up to max readable values with f(const T&), and only publish
+		// the new sequence at the end, so dependents see the whole batch at
+		// once. returns the number read
+		template <typename F>
+		size_type read_batch(F f, size_type max)
+		{
+			this->catch_up(is_overwrite());
+
+			auto seq = m_seq.val.load(std::memory_order_relaxed);
+			auto count = this->available();
+			if(static_cast<size_type>(count) > max) {
+				count = static_cast<sequence_type>(max);
+			}
+
+			sequence_type done = 0;
+			while(done < count) {
+				if(!this->read_one(seq + done, f, is_overwrite())) {
+					// lapped while reading, try again from the oldest
+					m_seq.val.store(seq + done, std::memory_order_release);
+					this->catch_up(is_overwrite());
+					return static_cast<size_type>(done);
+				}
+				++done;
+			}
+
+			m_seq.val.store(seq + done, std::memory_order_release);
+			return static_cast<size_type>(done);
+		}
+
+		// number of values read or skipped
+		sequence_type sequence() const
+		{
+			return m_seq.val.load(std::memory_order_acquire);
+		}
+
+		// number of values overwritten before they were read
+		sequence_type lost() const
+		{
+			return m_lost;
+		}
+	}; // }}}
+
+private: // variables
+
+	// slots, constructed up front and assigned to, or atomic_slots when
+	// overwriting
+	slot_ring slots;
+	size_type cap;
+
+	// values published, and so readable
+	cache_padded<std::atomic<sequence_type>> m_published;
+
+	// values claimed by the producer, only ahead of m_published while one
+	// is being written
+	// broadcast_overwrite only, since blocking never writes a slot a
+	// consumer may be reading
+	cache_padded<std::atomic<sequence_type>> m_claimed;
+
+	ring_buffer<std::unique_ptr<consumer>> consumers;
+
+	// producer only
+	// lowest consumer sequence, last time it was checked
+	sequence_type m_gate;
+
+private: // internal methods
+
+	// {{{ internal methods
+
+	sequence_type cap_signed() const
+	{
+		return static_cast<sequence_type>(cap);
+	}
+
+	size_type slot_of(sequence_type seq) const
+	{
+		return static_cast<size_type>(seq) % cap;
+	}
+
+	// broadcast_block only
+	T& slot(sequence_type seq)
+	{
+		return slots[this->slot_of(seq)];
+	}
+
+	// lowest sequence of all consumers
+	sequence_type slowest() const
+	{
+		auto low = m_published.val.load(std::memory_order_relaxed);
+		for(const auto& c : consumers) {
+			auto seq = c->m_seq.val.load(std::memory_order_acquire);
+			low = seq < low ? seq : low;
+		}
+		return low;
+	}
+
+	// tag dispatch
+	// true if seq can be written
+	bool has_space(sequence_type seq, std::false_type /* overwrite */)
+	{
+		if(seq - m_gate < cap_signed()) {
+			return true;
+		}
+		m_gate = this->slowest();
+		return seq - m_gate < cap_signed();
+	}
+
+	bool has_space(sequence_type /* seq */, std::true_type /* overwrite */)
+	{
+		return true;
+	}
+
+	template <typename F>
+	void write(sequence_type seq, F& fill)
+	{
+		this->claim(seq, is_overwrite());
+		this->fill_slot(seq, fill, is_overwrite());
+		m_published.val.store(seq + 1, std::memory_order_release);
+	}
+
+	// tag dispatch
+	// nothing to do, since readers never copy a slot which can be written
+	void claim(sequence_type /* seq */, std::false_type /* overwrite */)
+	{
+	}
+
+	void claim(sequence_type seq, std::true_type /* overwrite */)
+	{
+		m_claimed.val.store(seq + 1, std::memory_order_relaxed);
+		// readers check m_claimed after copying, so it must be visible
+		// before the slot is changed
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+
+	// tag dispatch
+	template <typename F>
+	void fill_slot(sequence_type seq, F& fill, std::false_type /* overwrite */)
+	{
+		fill(this->slot(seq));
+	}
+
+	// fill a copy, so a consumer copying the slot only sees atomic stores
+	template <typename F>
+	void fill_slot(sequence_type seq, F& fill, std::true_type /* overwrite */)
+	{
+		T value;
+		slots.load(this->slot_of(seq), value);
+		fill(value);
+		slots.store(this->slot_of(seq), value);
+	}
+
+	// tag dispatch
+	void init_slots(std::false_type /* overwrite */)
+	{
+		slots.resize(cap);
+	}
+
+	// atomic_slots start zeroed
+	void init_slots(std::true_type /* overwrite */)
+	{
+	}
+
+	// }}}
+
+public: // methods
+
+	explicit broadcast_ring(size_type capacity, const allocator_type& alloc = allocator_type())
+		: slots(capacity, alloc), cap(capacity), m_gate(0)
+	{
+		this->init_slots(is_overwrite());
+		m_published.val.store(0, std::memory_order_relaxed);
+		m_claimed.val.store(0, std::memory_order_relaxed);
+	}
+
+	broadcast_ring(const broadcast_ring&) = delete;
+	broadcast_ring& operator=(const broadcast_ring&) = delete;
+
+	// add a consumer, which only reads values once all of depends_on have
+	// read them. consumers start at the oldest value in the ring
+	// ensure: nothing has been published yet
+	consumer& add_consumer(std::initializer_list<const consumer*> depends_on = {})
+	{
+		std::unique_ptr<consumer> c(new consumer(this));
+		for(auto dep : depends_on) {
+			c->deps.push_back(dep);
+		}
+		consumers.push_back(std::move(c));
+		return *consumers.back();
+	}
+
+	// producer thread only
+	// write the next value with fill(T&), waiting if the ring is full
+	template <typename F>
+	void publish(F fill)
+	{
+		auto seq = m_published.val.load(std::memory_order_relaxed);
+		while(!this->has_space(seq, is_overwrite())) {
+			std::this_thread::yield();
+		}
+		this->write(seq, fill);
+	}
+
+	// producer thread only
+	void push(const T& value)
+	{
+		this->publish([&](T& dst) { dst = value; });
+	}
+
+	// producer thread only
+	// false if the ring is full (never, when overwriting)
+	bool try_push(const T& value)
+	{
+		auto seq = m_published.val.load(std::memory_order_relaxed);
+		if(!this->has_space(seq, is_overwrite())) {
+			return false;
+		}
+		auto fill = [&](T& dst) { dst = value; };
+		this->write(seq, fill);
+		return true;
+	}
+
+	// number of values published
+	sequence_type published() const
+	{
+		return m_published.val.load(std::memory_order_acquire);
+	}
+
+	size_type capacity() const
+	{
+		return cap;
+	}
+};
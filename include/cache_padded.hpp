@@ -0,0 +1,24 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Value padded out to a whole cache line, so values written by different
+ * threads don't share a line (false sharing).
+ *
+ * note: alignas would also do, but before C++17, operator new ignores
+ *       over-alignment, so padding only gives separate lines when the
+ *       padded values are next to each other.
+ */
+
+#include <cstddef>
+
+// assumed size of a cache line
+static constexpr std::size_t cache_line_size = 64;
+
+template <typename T>
+struct cache_padded
+{
+	T val;
+	char pad[cache_line_size > sizeof(T) ? cache_line_size - sizeof(T) : 1];
+};
@@ -0,0 +1,504 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Ring buffer made of fixed-size chunks, which grows without moving values.
+ *
+ * Values are stored in chunks of ChunkSize values each, and a ring_buffer of
+ * pointers to the chunks (the `map') keeps them in order. Growing at either
+ * end only allocates a chunk and adds it to the map, so existing values are
+ * never moved and references to them stay valid until they are popped.
+ *
+ * Random access goes through the map and then the chunk, so is O(1) with two
+ * indirections. Unlike ring_buffer, there is no insertion or erasure in the
+ * middle.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * template <typename T, std::size_t ChunkSize = (default), typename Allocator = std::allocator<T>>
+ * class chunked_ring_buffer
+ * {
+ * public:
+ *
+ *      chunked_ring_buffer();
+ *      explicit chunked_ring_buffer(const allocator_type& alloc);
+ *      chunked_ring_buffer(const chunked_ring_buffer& other);
+ *      chunked_ring_buffer(chunked_ring_buffer&& other);
+ *
+ *      reference operator[](size_type pos);
+ *      reference at(size_type pos);
+ *      reference front();
+ *      reference back();
+ *
+ *      iterator begin();
+ *      iterator end();
+ *
+ *      bool empty() const;
+ *      size_type size() const;
+ *      size_type chunk_count() const;
+ *
+ *      reference push_front(const value_type& value); // and T&&, emplace_front
+ *      reference push_back(const value_type& value);  // and T&&, emplace_back
+ *      void pop_front();
+ *      void pop_back();
+ *      void clear();
+ *      void swap(chunked_ring_buffer& other);
+ * };
+ *
+ * \endcode
+ */
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "index_iterator.hpp"
+#include "ring_buffer.hpp"
+
+// default to chunks of around 4KiB, but at least 16 values
+template <typename T>
+struct chunked_ring_buffer_default_chunk
+	: std::integral_constant<std::size_t, (sizeof(T) < 256 ? 4096 / sizeof(T) : 16)>
+{
+};
+
+template <typename T,
+          std::size_t ChunkSize = chunked_ring_buffer_default_chunk<T>::value,
+          typename Allocator = std::allocator<T>>
+class chunked_ring_buffer
+{
+private: // internal statics
+
+	using atraits = typename std::allocator_traits<Allocator>;
+
+	static_assert(std::is_same<T, typename atraits::value_type>::value,
+	              "Allocator must use the same type as T");
+	static_assert(ChunkSize > 0, "chunks must hold at least one value");
+
+public: // statics
+
+	// {{{ member types
+
+	using allocator_type         = typename atraits::allocator_type;
+	using value_type             = T;
+
+	using size_type              = typename atraits::size_type;
+	using difference_type        = typename atraits::difference_type;
+
+	using reference              = value_type&;
+	using const_reference        = const value_type&;
+
+	using pointer                = typename atraits::pointer;
+	using const_pointer          = typename atraits::const_pointer;
+
+	// }}}
+
+private: // internal statics
+
+	using map_alloc = typename atraits::template rebind_alloc<pointer>;
+	using map_type = ring_buffer<pointer, map_alloc>;
+
+	static constexpr size_type chunk_size = ChunkSize;
+
+public: // statics
+
+	// random access by index, so iterators stay valid as chunks are added
+	using iterator               = index_iterator<chunked_ring_buffer, pointer>;
+	using const_iterator         = index_iterator<const chunked_ring_buffer, const_pointer>;
+	using reverse_iterator       = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+private: // variables
+
+	// invariant: map holds exactly the chunks with values in them,
+	//            so it is empty iff there are no values
+
+	allocator_type mm; // `memory manager'
+	map_type map;
+
+	// a freed chunk, kept to avoid allocating when pushing and popping
+	// across a chunk boundary
+	pointer spare;
+
+	// offset of the first value, in the first chunk
+	size_type m_first;
+	size_type m_size;
+
+private: // internal methods
+
+	// {{{ internal methods
+
+	pointer alloc_chunk()
+	{
+		if(spare != nullptr) {
+			auto chunk = spare;
+			spare = nullptr;
+			return chunk;
+		}
+		return atraits::allocate(mm, chunk_size);
+	}
+
+	void free_chunk(pointer chunk)
+	{
+		if(spare == nullptr) {
+			spare = chunk;
+		} else {
+			atraits::deallocate(mm, chunk, chunk_size);
+		}
+	}
+
+	// construct a value at off in a new chunk, then add the chunk to the
+	// front or back of the map. the chunk is only added once it holds the
+	// value, and is freed if either throws, so the invariant holds
+	template <typename... Args>
+	void ctor_in_new_chunk(bool front, size_type off, Args&&... args)
+	{
+		auto chunk = this->alloc_chunk();
+		try {
+			atraits::construct(mm, chunk + off, std::forward<Args>(args)...);
+		} catch(...) {
+			this->free_chunk(chunk);
+			throw;
+		}
+
+		try {
+			// the map may grow, but only pointers to chunks are moved
+			if(front) {
+				map.push_front(chunk);
+			} else {
+				map.push_back(chunk);
+			}
+		} catch(...) {
+			atraits::destroy(mm, chunk + off);
+			this->free_chunk(chunk);
+			throw;
+		}
+	}
+
+	pointer ptr_of(size_type pos) const
+	{
+		auto off = m_first + pos;
+		return map[off / chunk_size] + off % chunk_size;
+	}
+
+	// false if failed
+	bool range_check(size_type pos) const
+	{
+		if(pos >= this->size()) {
+			throw std::out_of_range("chunked_ring_buffer::range_check: pos >= this->size()");
+			return false;
+		}
+		return true;
+	}
+
+	// }}}
+
+public: // methods
+
+	// {{{ basic functions
+
+	chunked_ring_buffer()
+		: chunked_ring_buffer(allocator_type())
+	{
+	}
+
+	explicit chunked_ring_buffer(const allocator_type& alloc)
+		: mm(alloc), map(map_alloc(alloc)), spare(nullptr)
+		, m_first(0), m_size(0)
+	{
+	}
+
+	chunked_ring_buffer(const chunked_ring_buffer& other)
+		: chunked_ring_buffer(atraits::select_on_container_copy_construction(other.mm))
+	{
+		for(const auto& val : other) {
+			this->push_back(val);
+		}
+	}
+
+	chunked_ring_buffer(chunked_ring_buffer&& other)
+		: mm(std::move(other.mm)), map(std::move(other.map)), spare(other.spare)
+		, m_first(other.m_first), m_size(other.m_size)
+	{
+		other.spare = nullptr;
+		other.m_first = other.m_size = 0;
+	}
+
+	~chunked_ring_buffer()
+	{
+		this->clear();
+		if(spare != nullptr) {
+			atraits::deallocate(mm, spare, chunk_size);
+		}
+	}
+
+	// copy and swap assignment
+	chunked_ring_buffer& operator=(chunked_ring_buffer other)
+	{
+		this->swap(other);
+		return *this;
+	}
+
+	allocator_type get_allocator() const
+	{
+		return mm;
+	}
+
+	// }}}
+
+	// {{{ element access
+
+	reference at(size_type pos)
+	{
+		this->range_check(pos);
+		return (*this)[pos];
+	}
+
+	const_reference at(size_type pos) const
+	{
+		this->range_check(pos);
+		return (*this)[pos];
+	}
+
+	reference operator[](size_type pos)
+	{
+		// ensure: this->range_check(pos)
+		return *this->ptr_of(pos);
+	}
+
+	const_reference operator[](size_type pos) const
+	{
+		// ensure: this->range_check(pos)
+		return *this->ptr_of(pos);
+	}
+
+	reference front()
+	{
+		// ensure: this->size() > 0
+		return (*this)[0];
+	}
+
+	const_reference front() const
+	{
+		// ensure: this->size() > 0
+		return (*this)[0];
+	}
+
+	reference back()
+	{
+		// ensure: this->size() > 0
+		return (*this)[m_size - 1];
+	}
+
+	const_reference back() const
+	{
+		// ensure: this->size() > 0
+		return (*this)[m_size - 1];
+	}
+
+	// }}}
+
+	// {{{ iterators
+
+	iterator begin()
+	{
+		return { this, 0 };
+	}
+
+	const_iterator begin() const
+	{
+		return this->cbegin();
+	}
+
+	const_iterator cbegin() const
+	{
+		return { this, 0 };
+	}
+
+	iterator end()
+	{
+		return { this, m_size };
+	}
+
+	const_iterator end() const
+	{
+		return this->cend();
+	}
+
+	const_iterator cend() const
+	{
+		return { this, m_size };
+	}
+
+	reverse_iterator rbegin()
+	{
+		return reverse_iterator(this->end());
+	}
+
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(this->cend());
+	}
+
+	reverse_iterator rend()
+	{
+		return reverse_iterator(this->begin());
+	}
+
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(this->cbegin());
+	}
+
+	// }}}
+
+	// {{{ capacity
+
+	bool empty() const
+	{
+		return m_size == 0;
+	}
+
+	size_type size() const
+	{
+		return m_size;
+	}
+
+	// number of chunks currently holding values
+	size_type chunk_count() const
+	{
+		return map.size();
+	}
+
+	// }}}
+
+	// {{{ modifiers
+
+	// invalidates: all values
+	void clear()
+	{
+		while(!this->empty()) {
+			this->pop_back();
+		}
+	}
+
+	// invalidates: iterators (if a chunk is added)
+	//              no references
+	reference push_front(const value_type& value)
+	{
+		return this->emplace_front(value);
+	}
+
+	// invalidates: iterators (if a chunk is added)
+	//              no references
+	reference push_front(value_type&& value)
+	{
+		return this->emplace_front(std::move(value));
+	}
+
+	// invalidates: iterators (if a chunk is added)
+	//              no references
+	template <typename... Args>
+	reference emplace_front(Args&&... args)
+	{
+		if(m_first == 0) {
+			this->ctor_in_new_chunk(true, chunk_size - 1, std::forward<Args>(args)...);
+			m_first = chunk_size;
+		} else {
+			atraits::construct(mm, map[0] + (m_first - 1), std::forward<Args>(args)...);
+		}
+		--m_first;
+		++m_size;
+
+		return this->front();
+	}
+
+	// invalidates: front
+	void pop_front()
+	{
+		// ensure: this->size() > 0
+		atraits::destroy(mm, map[0] + m_first);
+		++m_first;
+		--m_size;
+
+		if(m_first == chunk_size || m_size == 0) {
+			this->free_chunk(map.front());
+			map.pop_front();
+			m_first = 0;
+		}
+	}
+
+	// invalidates: iterators (if a chunk is added)
+	//              no references
+	reference push_back(const value_type& value)
+	{
+		return this->emplace_back(value);
+	}
+
+	// invalidates: iterators (if a chunk is added)
+	//              no references
+	reference push_back(value_type&& value)
+	{
+		return this->emplace_back(std::move(value));
+	}
+
+	// invalidates: iterators (if a chunk is added)
+	//              no references
+	template <typename... Args>
+	reference emplace_back(Args&&... args)
+	{
+		auto off = m_first + m_size;
+		if(off == map.size() * chunk_size) {
+			this->ctor_in_new_chunk(false, 0, std::forward<Args>(args)...);
+		} else {
+			atraits::construct(mm, map[off / chunk_size] + off % chunk_size, std::forward<Args>(args)...);
+		}
+		++m_size;
+
+		return this->back();
+	}
+
+	// invalidates: back
+	void pop_back()
+	{
+		// ensure: this->size() > 0
+		--m_size;
+		atraits::destroy(mm, this->ptr_of(m_size));
+
+		if((m_first + m_size) % chunk_size == 0 || m_size == 0) {
+			this->free_chunk(map.back());
+			map.pop_back();
+		}
+		if(m_size == 0) {
+			m_first = 0;
+		}
+	}
+
+	void swap(chunked_ring_buffer& other)
+	{
+		// for adl
+		using std::swap;
+
+		swap(mm, other.mm);
+		map.swap(other.map);
+		swap(spare, other.spare);
+		swap(m_first, other.m_first);
+		swap(m_size, other.m_size);
+	}
+
+	// }}}
+
+	friend void swap(chunked_ring_buffer& lhs, chunked_ring_buffer& rhs)
+	{
+		lhs.swap(rhs);
+	}
+
+};
@@ -0,0 +1,315 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Thread-safe, unbounded FIFO over a ring_buffer, with separate locks for
+ * the head and the tail, after Michael and Scott's two-lock queue.
+ *
+ * Producers only take the tail lock and consumers only the head lock, so
+ * they run in parallel. The count of values is kept in an atomic, which is
+ * how each side learns what the other has done: a consumer sees values
+ * only after the producer has constructed them, and a producer reuses
+ * slots only after the consumer has destroyed them.
+ *
+ * Growing moves every value, so a producer that needs more space takes the
+ * head lock as well, and grows with ring_buffer's own ensure_alloc_copy.
+ * The lock order is always tail then head.
+ *
+ * push_many() and pop_many() move a batch under one lock acquisition.
+ *
+ * A Watermark (see ring_buffer.hpp) is told of changes to the count in
+ * order. After each change, the thread which made it takes a notify lock,
+ * and tells the watermark of the move from the count it was last told of
+ * to the count now. So callbacks run one at a time, a crossing undone by
+ * the time its thread gets the lock may not be reported at all, and the
+ * last callback always matches the final count, e.g. a producer paused by
+ * on_high is always resumed once the ring drains. Callbacks run with the
+ * notify lock held, so must not push or pop. With the default
+ * ring_buffer_no_watermark, none of this is done.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * template <typename T, typename Allocator = std::allocator<T>, typename Watermark = ring_buffer_no_watermark>
+ * class concurrent_ring_buffer
+ * {
+ * public:
+ *
+ *      explicit concurrent_ring_buffer(size_type capacity = 0, const allocator_type& alloc = allocator_type());
+ *
+ *      // any thread
+ *      void push(const T& value); // and T&&
+ *      template <typename... Args> void emplace(Args&&... args);
+ *      template <typename ForwardIt> void push_many(ForwardIt first, ForwardIt last);
+ *
+ *      bool try_pop(T& out);
+ *      template <typename OutputIt> size_type pop_many(OutputIt out, size_type max);
+ *
+ *      bool empty() const; // approximate while in use
+ *      size_type size() const;
+ *      size_type capacity() const;
+ *
+ *      // set up before sharing between threads
+ *      Watermark& watermark();
+ * };
+ *
+ * \endcode
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#include "cache_padded.hpp"
+#include "ring_buffer.hpp"
+
+template <typename T, typename Allocator = std::allocator<T>, typename Watermark = ring_buffer_no_watermark>
+class concurrent_ring_buffer
+{
+private: // internal statics
+
+	using ring = ring_buffer<T, Allocator>;
+
+public: // statics
+
+	using allocator_type = Allocator;
+	using value_type     = T;
+	using size_type      = typename ring::size_type;
+	using watermark_type = Watermark;
+
+private: // variables
+
+	// invariant: the head lock guards m_begin, and the tail lock guards
+	//            m_end. the memblk is only replaced with both held
+	ring values;
+
+	// number of values, the only state both sides read
+	cache_padded<std::atomic<size_type>> m_size;
+
+	mutable cache_padded<std::mutex> head_lock;
+	mutable cache_padded<std::mutex> tail_lock;
+
+	// guards wm and m_notified
+	std::mutex notify_lock;
+	watermark_type wm;
+	// count the watermark was last told of
+	size_type m_notified;
+
+private: // internal statics
+
+	using has_watermark = std::integral_constant<bool, !std::is_same<Watermark, ring_buffer_no_watermark>::value>;
+
+private: // internal methods
+
+	// {{{ internal methods
+
+	// after changing m_size, with no lock held
+	void notify()
+	{
+		this->notify(has_watermark());
+	}
+
+	// tag dispatch
+	void notify(std::false_type /* has watermark */)
+	{
+	}
+
+	void notify(std::true_type /* has watermark */)
+	{
+		std::lock_guard<std::mutex> guard(notify_lock);
+		// at least as new as the change made by this thread, so whichever
+		// thread notifies last sees the final count
+		auto now = m_size.val.load(std::memory_order_acquire);
+		if(now != m_notified) {
+			auto old_size = m_notified;
+			m_notified = now;
+			wm.on_size(old_size, now);
+		}
+	}
+
+	// tail lock held
+	// make space for count more values
+	void ensure_space(size_type count)
+	{
+		if(m_size.val.load(std::memory_order_acquire) + count <= values.capacity()) {
+			return;
+		}
+
+		// consumers may only have made space since checking, but growing
+		// moves values from under them
+		std::lock_guard<std::mutex> head_guard(head_lock.val);
+		values.ensure_alloc_copy_extra(values.size() + count);
+	}
+
+	// tail lock held, and space for the value
+	template <typename... Args>
+	void ctor_back(Args&&... args)
+	{
+		values.ctor_value(values.m_end, std::forward<Args>(args)...);
+		values.m_end = static_cast<typename ring::index_type>(values.abs_offset_of(values.m_end + size_type(1)));
+	}
+
+	// head lock held, and a value to pop
+	void dtor_front()
+	{
+		values.dtor_value(values.m_begin);
+		values.m_begin = static_cast<typename ring::index_type>(values.abs_offset_of(values.m_begin + size_type(1)));
+	}
+
+	// }}}
+
+public: // methods
+
+	explicit concurrent_ring_buffer(size_type capacity = 0, const allocator_type& alloc = allocator_type())
+		: values(capacity, alloc), m_notified(0)
+	{
+		m_size.val.store(0, std::memory_order_relaxed);
+	}
+
+	concurrent_ring_buffer(const concurrent_ring_buffer&) = delete;
+	concurrent_ring_buffer& operator=(const concurrent_ring_buffer&) = delete;
+
+	// {{{ producers
+
+	// any thread
+	template <typename... Args>
+	void emplace(Args&&... args)
+	{
+		{
+			std::lock_guard<std::mutex> guard(tail_lock.val);
+			this->ensure_space(1);
+			this->ctor_back(std::forward<Args>(args)...);
+			m_size.val.fetch_add(1, std::memory_order_release);
+		}
+		this->notify();
+	}
+
+	// any thread
+	void push(const value_type& value)
+	{
+		this->emplace(value);
+	}
+
+	// any thread
+	void push(value_type&& value)
+	{
+		this->emplace(std::move(value));
+	}
+
+	// any thread
+	// push [first, last) under one lock, so consumers see them in a row
+	template <typename ForwardIt>
+	void push_many(ForwardIt first, ForwardIt last)
+	{
+		auto count = static_cast<size_type>(std::distance(first, last));
+		if(count == 0) {
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(tail_lock.val);
+			this->ensure_space(count);
+
+			size_type done = 0;
+			try {
+				for(; first != last; ++first, ++done) {
+					this->ctor_back(*first);
+				}
+			} catch(...) {
+				// keep the values which were pushed
+				m_size.val.fetch_add(done, std::memory_order_release);
+				// the notify lock is always taken last, so this can't deadlock
+				this->notify();
+				throw;
+			}
+			m_size.val.fetch_add(count, std::memory_order_release);
+		}
+		this->notify();
+	}
+
+	// }}}
+
+	// {{{ consumers
+
+	// any thread
+	// false if empty
+	bool try_pop(value_type& out)
+	{
+		return this->pop_many(&out, 1) == 1;
+	}
+
+	// any thread
+	// move up to max values to out under one lock
+	// returns the number popped
+	template <typename OutputIt>
+	size_type pop_many(OutputIt out, size_type max)
+	{
+		size_type count;
+		{
+			std::lock_guard<std::mutex> guard(head_lock.val);
+
+			count = m_size.val.load(std::memory_order_acquire);
+			if(count > max) {
+				count = max;
+			}
+			if(count == 0) {
+				return 0;
+			}
+
+			size_type done = 0;
+			try {
+				for(; done < count; ++done) {
+					*out = std::move(*values.ptr_of(values.m_begin));
+					++out;
+					this->dtor_front();
+				}
+			} catch(...) {
+				m_size.val.fetch_sub(done, std::memory_order_release);
+				this->notify();
+				throw;
+			}
+			m_size.val.fetch_sub(count, std::memory_order_release);
+		}
+		this->notify();
+		return count;
+	}
+
+	// }}}
+
+	// {{{ capacity
+
+	// approximate while in use
+	bool empty() const
+	{
+		return this->size() == 0;
+	}
+
+	// approximate while in use
+	size_type size() const
+	{
+		return m_size.val.load(std::memory_order_acquire);
+	}
+
+	size_type capacity() const
+	{
+		std::lock_guard<std::mutex> guard(tail_lock.val);
+		return values.capacity();
+	}
+
+	// }}}
+
+	// thresholds and callbacks, if Watermark has any
+	// not synchronised, so set up before sharing between threads
+	watermark_type& watermark()
+	{
+		return wm;
+	}
+};
@@ -0,0 +1,480 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Compressed ring of integers, for long time series of values which only
+ * change a little from one to the next, e.g. counters or timestamps.
+ *
+ * Values go in fixed-size blocks, kept in a ring_buffer. A block stores its
+ * first value in full, then each following value as the difference from the
+ * one before, zig-zag encoded so small negative differences are small too,
+ * in a little-endian base 128 varint. A difference below 64 in either
+ * direction takes one byte, so a series which changes slowly takes one or two
+ * bytes per value instead of eight.
+ *
+ * Values are appended at the back, and dropped from the front a block at a
+ * time, which is how a retention window is kept. Reading is sequential:
+ * iterators decode as they go, and decode_block() and for_each() decode a
+ * whole block in one tight loop, which is faster.
+ *
+ * Differences are taken modulo 2^N, so any sequence of values round trips;
+ * ones which jump about just don't compress.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * template <typename Int = std::int64_t, std::size_t BlockBytes = 256, typename Allocator = std::allocator<Int>>
+ * class delta_ring
+ * {
+ * public:
+ *
+ *      static constexpr size_type max_block_values;
+ *
+ *      explicit delta_ring(const allocator_type& alloc = allocator_type());
+ *
+ *      void push_back(Int value);
+ *
+ *      // drop the oldest block, returns the number of values dropped
+ *      size_type pop_front_block();
+ *      void clear();
+ *
+ *      Int front() const;
+ *      Int back() const;
+ *      bool empty() const;
+ *      size_type size() const;
+ *
+ *      size_type block_count() const;
+ *      size_type block_size(size_type block) const;
+ *      size_type decode_block(size_type block, Int* out) const; // out holds max_block_values
+ *      template <typename F> void for_each(F f) const; // f(Int), oldest first
+ *
+ *      // bytes of blocks allocated
+ *      size_type memory_bytes() const;
+ *      void reserve_blocks(size_type count);
+ *      void shrink_to_fit();
+ *
+ *      const_iterator begin() const; // input iterators
+ *      const_iterator end() const;
+ * };
+ *
+ * \endcode
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#include "ring_buffer.hpp"
+
+namespace delta_ring_detail {
+
+// {{{ encoding
+
+// maps ..., -2, -1, 0, 1, 2, ... to ..., 3, 1, 0, 2, 4, ...
+template <typename U>
+U zigzag(U delta)
+{
+	return static_cast<U>(static_cast<U>(delta << 1) ^ static_cast<U>(U(0) - (delta >> (std::numeric_limits<U>::digits - 1))));
+}
+
+template <typename U>
+U unzigzag(U zz)
+{
+	return static_cast<U>((zz >> 1) ^ static_cast<U>(U(0) - (zz & 1)));
+}
+
+template <typename U>
+std::size_t varint_size(U val)
+{
+	std::size_t n = 1;
+	while(val >= 0x80) {
+		val = static_cast<U>(val >> 7);
+		++n;
+	}
+	return n;
+}
+
+template <typename U>
+unsigned char* put_varint(unsigned char* out, U val)
+{
+	while(val >= 0x80) {
+		*out++ = static_cast<unsigned char>(val | 0x80);
+		val = static_cast<U>(val >> 7);
+	}
+	*out++ = static_cast<unsigned char>(val);
+	return out;
+}
+
+template <typename U>
+const unsigned char* get_varint(const unsigned char* in, U& val)
+{
+	// one byte is by far the most common case
+	if(*in < 0x80) {
+		val = *in;
+		return in + 1;
+	}
+
+	U out = 0;
+	int shift = 0;
+	while(*in >= 0x80) {
+		out = static_cast<U>(out | static_cast<U>(static_cast<U>(*in & 0x7f) << shift));
+		shift += 7;
+		++in;
+	}
+	val = static_cast<U>(out | static_cast<U>(static_cast<U>(*in) << shift));
+	return in + 1;
+}
+
+// }}}
+
+} // namespace delta_ring_detail
+
+template <typename Int = std::int64_t, std::size_t BlockBytes = 256, typename Allocator = std::allocator<Int>>
+class delta_ring
+{
+private: // internal statics
+
+	static_assert(std::is_integral<Int>::value, "delta_ring only holds integers");
+
+	using atraits = typename std::allocator_traits<Allocator>;
+	using unsigned_type = typename std::make_unsigned<Int>::type;
+
+	// worst case bytes for one delta
+	static constexpr std::size_t max_varint = (std::numeric_limits<unsigned_type>::digits + 6) / 7;
+	// count and used first, so there's no padding whatever Int is
+	static constexpr std::size_t header_bytes = 2 * sizeof(std::uint32_t) + 2 * sizeof(Int);
+
+	static_assert(BlockBytes >= header_bytes + max_varint, "blocks must have room for at least one delta");
+	static_assert(BlockBytes - header_bytes < (std::size_t(1) << 31), "block sizes must fit in the header");
+
+	struct block
+	{
+		std::uint32_t count; // values, including first
+		std::uint32_t used;  // bytes of data
+		Int first;
+		Int last;
+		unsigned char data[BlockBytes - header_bytes];
+	};
+
+	using block_alloc = typename atraits::template rebind_alloc<block>;
+	using block_ring = ring_buffer<block, block_alloc>;
+
+public: // statics
+
+	using allocator_type = Allocator;
+	using value_type     = Int;
+	using size_type      = typename block_ring::size_type;
+
+	// most values one block can hold, when every delta takes a byte
+	static constexpr size_type max_block_values = BlockBytes - header_bytes + 1;
+
+	class const_iterator;
+
+private: // variables
+
+	block_ring blocks;
+	size_type m_size;
+
+private: // internal methods
+
+	// {{{ internal methods
+
+	static Int from_unsigned(unsigned_type val)
+	{
+		return static_cast<Int>(val);
+	}
+
+	void push_block(Int value)
+	{
+		block blk;
+		blk.count = 1;
+		blk.used = 0;
+		blk.first = value;
+		blk.last = value;
+		blocks.push_back(blk);
+	}
+
+	// add value to the end of blk, false if its delta doesn't fit
+	bool append(block& blk, Int value)
+	{
+		auto delta = static_cast<unsigned_type>(static_cast<unsigned_type>(value) - static_cast<unsigned_type>(blk.last));
+		auto zz = delta_ring_detail::zigzag(delta);
+		auto len = delta_ring_detail::varint_size(zz);
+
+		if(blk.used + len > sizeof(blk.data)) {
+			return false;
+		}
+
+		delta_ring_detail::put_varint(blk.data + blk.used, zz);
+		blk.used += static_cast<std::uint32_t>(len);
+		++blk.count;
+		blk.last = value;
+		return true;
+	}
+
+	// }}}
+
+public: // methods
+
+	explicit delta_ring(const allocator_type& alloc = allocator_type())
+		: blocks(block_alloc(alloc)), m_size(0)
+	{
+	}
+
+	// {{{ modifiers
+
+	// invalidates: iterators
+	void push_back(Int value)
+	{
+		if(blocks.empty() || !this->append(blocks.back(), value)) {
+			this->push_block(value);
+		}
+		// after, so a push which throws leaves the size alone
+		++m_size;
+	}
+
+	// drop the oldest block
+	// returns the number of values dropped, 0 if empty
+	// invalidates: iterators
+	size_type pop_front_block()
+	{
+		if(blocks.empty()) {
+			return 0;
+		}
+		size_type dropped = blocks.front().count;
+		blocks.pop_front();
+		m_size -= dropped;
+		return dropped;
+	}
+
+	// keeps allocated blocks
+	// invalidates: iterators
+	void clear()
+	{
+		blocks.clear();
+		m_size = 0;
+	}
+
+	// }}}
+
+	// {{{ access
+
+	Int front() const
+	{
+		return blocks.front().first;
+	}
+
+	Int back() const
+	{
+		return blocks.back().last;
+	}
+
+	bool empty() const
+	{
+		return m_size == 0;
+	}
+
+	size_type size() const
+	{
+		return m_size;
+	}
+
+	// }}}
+
+	// {{{ blocks
+
+	size_type block_count() const
+	{
+		return blocks.size();
+	}
+
+	// values in a block, 0 being the oldest
+	size_type block_size(size_type block_idx) const
+	{
+		return blocks[block_idx].count;
+	}
+
+	// decode the values in a block, 0 being the oldest, to out, which must
+	// have room for max_block_values
+	// returns the number of values
+	size_type decode_block(size_type block_idx, Int* out) const
+	{
+		const auto& blk = blocks[block_idx];
+		auto in = blk.data;
+		auto cur = static_cast<unsigned_type>(blk.first);
+
+		out[0] = blk.first;
+		for(std::uint32_t i = 1; i < blk.count; ++i) {
+			unsigned_type zz;
+			in = delta_ring_detail::get_varint(in, zz);
+			cur = static_cast<unsigned_type>(cur + delta_ring_detail::unzigzag(zz));
+			out[i] = from_unsigned(cur);
+		}
+		return blk.count;
+	}
+
+	// call f(Int) on each value, oldest first
+	template <typename F>
+	void for_each(F f) const
+	{
+		Int buf[max_block_values];
+		for(size_type b = 0; b < blocks.size(); ++b) {
+			auto n = this->decode_block(b, buf);
+			for(size_type i = 0; i < n; ++i) {
+				f(buf[i]);
+			}
+		}
+	}
+
+	// bytes of blocks allocated, whether or not in use
+	size_type memory_bytes() const
+	{
+		return blocks.capacity() * sizeof(block);
+	}
+
+	// invalidates: iterators, if a reallocation occurs
+	void reserve_blocks(size_type count)
+	{
+		blocks.reserve(count);
+	}
+
+	// invalidates: iterators
+	void shrink_to_fit()
+	{
+		blocks.shrink_to_fit();
+	}
+
+	// }}}
+
+	// {{{ iterators
+
+	const_iterator begin() const
+	{
+		return const_iterator(&blocks, 0);
+	}
+
+	const_iterator end() const
+	{
+		return const_iterator(&blocks, blocks.size());
+	}
+
+	const_iterator cbegin() const
+	{
+		return this->begin();
+	}
+
+	const_iterator cend() const
+	{
+		return this->end();
+	}
+
+	// }}}
+};
+
+template <typename Int, std::size_t BlockBytes, typename Allocator>
+constexpr typename delta_ring<Int, BlockBytes, Allocator>::size_type delta_ring<Int, BlockBytes, Allocator>::max_block_values;
+
+// {{{ const_iterator
+
+// decodes as it goes, so is only an input iterator: the value it refers to
+// is held in the iterator itself
+template <typename Int, std::size_t BlockBytes, typename Allocator>
+class delta_ring<Int, BlockBytes, Allocator>::const_iterator
+{
+public: // statics
+
+	using iterator_category = std::input_iterator_tag;
+	using value_type        = Int;
+	using difference_type   = std::ptrdiff_t;
+	using pointer           = const Int*;
+	using reference         = const Int&;
+
+private: // variables
+
+	const block_ring* blocks;
+	size_type blk;
+	std::uint32_t idx; // within the block
+	const unsigned char* in;
+	unsigned_type cur;
+
+	friend class delta_ring;
+
+private: // internal methods
+
+	// {{{ internal methods
+
+	const_iterator(const block_ring* i_blocks, size_type i_blk)
+		: blocks(i_blocks), blk(i_blk), idx(0), in(nullptr), cur(0)
+	{
+		this->enter_block();
+	}
+
+	void enter_block()
+	{
+		idx = 0;
+		if(blk < blocks->size()) {
+			const auto& b = (*blocks)[blk];
+			in = b.data;
+			cur = static_cast<unsigned_type>(b.first);
+		}
+	}
+
+	// }}}
+
+public: // methods
+
+	const_iterator()
+		: blocks(nullptr), blk(0), idx(0), in(nullptr), cur(0)
+	{
+	}
+
+	reference operator*() const
+	{
+		// Int and its unsigned type may alias
+		return reinterpret_cast<const Int&>(cur);
+	}
+
+	pointer operator->() const
+	{
+		return &**this;
+	}
+
+	const_iterator& operator++()
+	{
+		if(++idx < (*blocks)[blk].count) {
+			unsigned_type zz;
+			in = delta_ring_detail::get_varint(in, zz);
+			cur = static_cast<unsigned_type>(cur + delta_ring_detail::unzigzag(zz));
+		} else {
+			++blk;
+			this->enter_block();
+		}
+		return *this;
+	}
+
+	const_iterator operator++(int)
+	{
+		auto copy = *this;
+		++*this;
+		return copy;
+	}
+
+	friend bool operator==(const const_iterator& a, const const_iterator& b)
+	{
+		return a.blk == b.blk && a.idx == b.idx;
+	}
+
+	friend bool operator!=(const const_iterator& a, const const_iterator& b)
+	{
+		return !(a == b);
+	}
+};
+
+// }}}
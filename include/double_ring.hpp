@@ -0,0 +1,145 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Double-buffered batch handoff, for collecting values from any thread and
+ * processing them all at once, e.g. at the end of a frame.
+ *
+ * Producers append to the active ring_buffer. The consumer swaps in the
+ * standby, which takes a pointer swap under the producers' lock, and then
+ * owns the full ring: it iterates it like any other ring_buffer, with no
+ * synchronisation per value. At the next swap, that ring is cleared and
+ * becomes the active one again. clear() keeps the capacity, so once both
+ * rings have grown to a frame's worth of values, nothing is reallocated.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * template <typename T, typename Allocator = std::allocator<T>>
+ * class double_ring
+ * {
+ * public:
+ *
+ *      explicit double_ring(size_type capacity = 0, const allocator_type& alloc = allocator_type());
+ *
+ *      // any thread
+ *      void push(const T& value); // and T&&
+ *      template <typename... Args> void emplace(Args&&... args);
+ *      template <typename InputIt> void push_many(InputIt first, InputIt last);
+ *
+ *      // one consumer thread
+ *      ring_buffer<T, Allocator>& swap_out(); // valid until the next swap_out
+ *      template <typename F> size_type drain(F f); // f(T&)
+ * };
+ *
+ * \endcode
+ */
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "ring_buffer.hpp"
+
+template <typename T, typename Allocator = std::allocator<T>>
+class double_ring
+{
+public: // statics
+
+	using ring           = ring_buffer<T, Allocator>;
+	using allocator_type = Allocator;
+	using value_type     = T;
+	using size_type      = typename ring::size_type;
+
+private: // variables
+
+	ring rings[2];
+
+	// guards active, and the ring it points to
+	std::mutex lock;
+	ring* active;
+
+	// consumer only, the ring handed out by the last swap_out
+	ring* standby;
+
+public: // methods
+
+	explicit double_ring(size_type capacity = 0, const allocator_type& alloc = allocator_type())
+		: rings{ ring(capacity, alloc), ring(capacity, alloc) }
+		, active(&rings[0]), standby(&rings[1])
+	{
+	}
+
+	double_ring(const double_ring&) = delete;
+	double_ring& operator=(const double_ring&) = delete;
+
+	// {{{ producers
+
+	// any thread
+	template <typename... Args>
+	void emplace(Args&&... args)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		active->emplace_back(std::forward<Args>(args)...);
+	}
+
+	// any thread
+	void push(const value_type& value)
+	{
+		this->emplace(value);
+	}
+
+	// any thread
+	void push(value_type&& value)
+	{
+		this->emplace(std::move(value));
+	}
+
+	// any thread
+	// append [first, last) under one lock, so they stay together
+	template <typename InputIt>
+	void push_many(InputIt first, InputIt last)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		active->insert(active->end(), first, last);
+	}
+
+	// }}}
+
+	// {{{ consumer
+
+	// one consumer thread
+	// take everything pushed so far, and make an empty ring active
+	// the returned ring belongs to the consumer until the next swap_out,
+	// which clears it (keeping its capacity) for reuse
+	ring& swap_out()
+	{
+		// outside the lock, since producers can't see the standby
+		standby->clear();
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			std::swap(active, standby);
+		}
+		return *standby;
+	}
+
+	// one consumer thread
+	// swap out, then call f(T&) on each value, oldest first
+	// returns the number of values
+	template <typename F>
+	size_type drain(F f)
+	{
+		auto& batch = this->swap_out();
+		for(auto& val : batch) {
+			f(val);
+		}
+		return batch.size();
+	}
+
+	// }}}
+};
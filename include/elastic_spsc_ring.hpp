@@ -0,0 +1,251 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Unbounded single producer, single consumer queue, made of a linked list of
+ * spsc_ring segments.
+ *
+ * The producer pushes into the newest segment. When it fills, the producer
+ * links in a segment twice the size (up to a maximum), and carries on there.
+ * The consumer pops from the oldest segment, and once it is drained and has
+ * a successor, moves over and recycles it. Neither side waits for the other,
+ * and neither takes a lock.
+ *
+ * Recycled segments go in a pool of one spare, which the producer takes
+ * before allocating, so a queue which stays at the maximum segment size
+ * reuses memory instead of allocating.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * template <typename T, typename Allocator = std::allocator<T>>
+ * class elastic_spsc_ring
+ * {
+ * public:
+ *
+ *      explicit elastic_spsc_ring(size_type initial_capacity = 64, size_type max_segment = 65536,
+ *                                 const allocator_type& alloc = allocator_type());
+ *
+ *      // producer thread only
+ *      void push(const T& value); // and T&&
+ *      template <typename... Args> void emplace(Args&&... args);
+ *
+ *      // consumer thread only
+ *      bool try_pop(T& out);
+ *      bool empty() const;
+ *      size_type segment_count() const;
+ * };
+ *
+ * \endcode
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "cache_padded.hpp"
+#include "spsc_ring.hpp"
+
+template <typename T, typename Allocator = std::allocator<T>>
+class elastic_spsc_ring
+{
+private: // internal statics
+
+	using atraits = typename std::allocator_traits<Allocator>;
+
+public: // statics
+
+	using allocator_type = typename atraits::allocator_type;
+	using value_type     = T;
+	using size_type      = typename atraits::size_type;
+
+private: // internal statics
+
+	struct segment
+	{
+		spsc_ring<T, Allocator> values;
+		// set by the producer once it stops pushing to this segment
+		std::atomic<segment*> next;
+
+		segment(size_type cap, const Allocator& alloc)
+			: values(cap, alloc), next(nullptr)
+		{
+		}
+	};
+
+	using segment_alloc = typename atraits::template rebind_alloc<segment>;
+	using segment_traits = std::allocator_traits<segment_alloc>;
+
+private: // variables
+
+	// consumer only, oldest segment
+	cache_padded<segment*> m_head;
+	// producer only, newest segment
+	cache_padded<segment*> m_tail;
+	// drained segment, given from the consumer to the producer
+	cache_padded<std::atomic<segment*>> m_spare;
+
+	segment_alloc mm; // `memory manager'
+	size_type max_seg;
+
+private: // internal methods
+
+	// {{{ internal methods
+
+	segment* alloc_segment(size_type cap)
+	{
+		auto seg = segment_traits::allocate(mm, 1);
+		segment_traits::construct(mm, seg, cap, Allocator(mm));
+		return seg;
+	}
+
+	void free_segment(segment* seg)
+	{
+		segment_traits::destroy(mm, seg);
+		segment_traits::deallocate(mm, seg, 1);
+	}
+
+	// producer only
+	// the next segment, from the spare if it is big enough
+	segment* make_segment(size_type cap)
+	{
+		auto seg = m_spare.val.exchange(nullptr, std::memory_order_acquire);
+		if(seg != nullptr && seg->values.capacity() >= cap) {
+			return seg;
+		}
+		if(seg != nullptr) {
+			this->free_segment(seg);
+		}
+		return this->alloc_segment(cap);
+	}
+
+	// consumer only
+	// keep a drained segment as the spare, or free it if there already is one
+	void recycle(segment* seg)
+	{
+		seg->next.store(nullptr, std::memory_order_relaxed);
+		segment* expected = nullptr;
+		if(!m_spare.val.compare_exchange_strong(expected, seg, std::memory_order_release, std::memory_order_relaxed)) {
+			this->free_segment(seg);
+		}
+	}
+
+	// }}}
+
+public: // methods
+
+	explicit elastic_spsc_ring(size_type initial_capacity = 64, size_type max_segment = 65536,
+	                           const allocator_type& alloc = allocator_type())
+		: mm(alloc), max_seg(max_segment < initial_capacity ? initial_capacity : max_segment)
+	{
+		m_spare.val.store(nullptr, std::memory_order_relaxed);
+		m_head.val = m_tail.val = this->alloc_segment(initial_capacity);
+	}
+
+	elastic_spsc_ring(const elastic_spsc_ring&) = delete;
+	elastic_spsc_ring& operator=(const elastic_spsc_ring&) = delete;
+
+	// ensure: no other thread is using the queue
+	~elastic_spsc_ring()
+	{
+		auto seg = m_head.val;
+		while(seg != nullptr) {
+			auto next = seg->next.load(std::memory_order_relaxed);
+			this->free_segment(seg);
+			seg = next;
+		}
+		if(auto spare = m_spare.val.load(std::memory_order_relaxed)) {
+			this->free_segment(spare);
+		}
+	}
+
+	// {{{ producer
+
+	// producer thread only
+	// never fails, linking in a bigger segment if the current one is full
+	template <typename... Args>
+	void emplace(Args&&... args)
+	{
+		auto tail = m_tail.val;
+		if(tail->values.try_emplace(std::forward<Args>(args)...)) {
+			return;
+		}
+
+		auto cap = 2 * tail->values.capacity();
+		auto seg = this->make_segment(cap < max_seg ? cap : max_seg);
+		// a new segment is empty, so this can't fail
+		seg->values.try_emplace(std::forward<Args>(args)...);
+
+		// the consumer moves over once it sees this, so everything pushed to
+		// the old segment must be visible first
+		tail->next.store(seg, std::memory_order_release);
+		m_tail.val = seg;
+	}
+
+	// producer thread only
+	void push(const value_type& value)
+	{
+		this->emplace(value);
+	}
+
+	// producer thread only
+	void push(value_type&& value)
+	{
+		this->emplace(std::move(value));
+	}
+
+	// }}}
+
+	// {{{ consumer
+
+	// consumer thread only
+	// false if empty
+	bool try_pop(value_type& out)
+	{
+		while(true) {
+			auto head = m_head.val;
+			if(head->values.try_pop(out)) {
+				return true;
+			}
+
+			auto next = head->next.load(std::memory_order_acquire);
+			if(next == nullptr) {
+				return false;
+			}
+
+			// the producer may have pushed more before moving on
+			if(head->values.try_pop(out)) {
+				return true;
+			}
+
+			m_head.val = next;
+			this->recycle(head);
+		}
+	}
+
+	// consumer thread only
+	// approximate while the producer is active
+	bool empty() const
+	{
+		auto head = m_head.val;
+		return head->values.empty() && head->next.load(std::memory_order_acquire) == nullptr;
+	}
+
+	// consumer thread only
+	// segments in use, approximate while the producer is active
+	size_type segment_count() const
+	{
+		size_type count = 0;
+		for(auto seg = m_head.val; seg != nullptr; seg = seg->next.load(std::memory_order_acquire)) {
+			++count;
+		}
+		return count;
+	}
+
+	// }}}
+};
@@ -0,0 +1,278 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Always-on per-thread tracing into overwriting rings, which can be dumped
+ * from a crash handler.
+ *
+ * Each thread records fixed-size flight_events into its own ring_buffer,
+ * created the first time the thread records. Once full, the oldest event is
+ * dropped for each new one, so after the first event there is no locking and
+ * no allocation. Rings are listed in a fixed table of atomic slots, so a
+ * signal handler can find them all without locks.
+ *
+ * dump() writes every ring to a file descriptor with writev, taking each
+ * ring's values as the (at most two) segments they are stored in, so it only
+ * makes async-signal-safe calls. install_crash_handler() dumps on SIGSEGV and
+ * SIGABRT, then re-raises the signal. Other threads keep running while the
+ * handler reads their rings, so the dump is best effort: an event being
+ * written at the time may come out garbled, but reading never goes outside a
+ * ring's memory.
+ *
+ * Dump format, in native byte order: a file header, then for each thread, a
+ * thread header followed by its events, oldest first. tools/flight_decode.cpp
+ * prints a dump.
+ *
+ * note: POSIX only.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * struct flight_event
+ * {
+ *      std::uint64_t time; // steady_clock, in ns
+ *      std::uint32_t id;
+ *      std::uint32_t arg;
+ *      std::uint64_t data;
+ * };
+ *
+ * namespace flight_recorder {
+ *
+ *      // events per thread, for threads which haven't recorded yet
+ *      void set_capacity(std::size_t events);
+ *
+ *      void record(std::uint32_t id, std::uint32_t arg = 0, std::uint64_t data = 0);
+ *
+ *      // async-signal-safe
+ *      bool dump(int fd);
+ *
+ *      // dump to fd on SIGSEGV and SIGABRT
+ *      bool install_crash_handler(int fd);
+ *
+ * }
+ *
+ * \endcode
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#include <signal.h>
+#include <sys/uio.h>
+
+#include "ring_buffer.hpp"
+#include "ring_buffer_io.hpp"
+
+struct flight_event
+{
+	std::uint64_t time;
+	std::uint32_t id;
+	std::uint32_t arg;
+	std::uint64_t data;
+};
+
+namespace flight_recorder_detail {
+
+// {{{ dump format
+
+struct file_header
+{
+	char magic[4]; // "FLRC"
+	std::uint32_t event_size;
+};
+
+struct thread_header
+{
+	std::uint64_t thread; // order the thread first recorded in
+	std::uint64_t count;
+};
+
+// }}}
+
+using event_ring = ring_buffer<flight_event>;
+
+// threads whose rings are dumped, any more are recorded but not dumped
+static constexpr std::size_t max_threads = 256;
+
+struct slot
+{
+	std::atomic<const event_ring*> ring;
+	std::atomic<std::uint64_t> thread;
+};
+
+// zero initialised before anything runs, so safe to use from a handler
+inline slot* slots()
+{
+	static slot table[max_threads];
+	return table;
+}
+
+inline std::atomic<std::size_t>& capacity()
+{
+	static std::atomic<std::size_t> cap(4096);
+	return cap;
+}
+
+inline std::atomic<int>& crash_fd()
+{
+	static std::atomic<int> fd(-1);
+	return fd;
+}
+
+// this thread's ring, listed in a slot while the thread lives
+class local_ring
+{
+private:
+
+	event_ring ring;
+	slot* listed;
+
+public:
+
+	local_ring()
+		: ring(), listed(nullptr)
+	{
+		static std::atomic<std::uint64_t> threads(0);
+
+		ring.reserve(capacity().load(std::memory_order_relaxed));
+
+		auto thread = threads.fetch_add(1, std::memory_order_relaxed);
+		auto table = slots();
+		for(std::size_t i = 0; i < max_threads; ++i) {
+			const event_ring* expected = nullptr;
+			if(table[i].ring.load(std::memory_order_relaxed) == nullptr
+				&& table[i].ring.compare_exchange_strong(expected, &ring, std::memory_order_acq_rel)) {
+				table[i].thread.store(thread, std::memory_order_release);
+				listed = &table[i];
+				break;
+			}
+		}
+	}
+
+	local_ring(const local_ring&) = delete;
+	local_ring& operator=(const local_ring&) = delete;
+
+	~local_ring()
+	{
+		if(listed != nullptr) {
+			listed->ring.store(nullptr, std::memory_order_release);
+		}
+	}
+
+	void push(const flight_event& ev)
+	{
+		if(ring.capacity() == 0) {
+			return;
+		}
+		if(ring.size() == ring.capacity()) {
+			ring.pop_front();
+		}
+		ring.push_back(ev);
+	}
+};
+
+} // namespace flight_recorder_detail
+
+namespace flight_recorder {
+
+// events kept per thread, for threads which haven't recorded yet
+inline void set_capacity(std::size_t events)
+{
+	flight_recorder_detail::capacity().store(events, std::memory_order_relaxed);
+}
+
+inline void record(std::uint32_t id, std::uint32_t arg = 0, std::uint64_t data = 0)
+{
+	static thread_local flight_recorder_detail::local_ring ring;
+
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	flight_event ev;
+	ev.time = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+	ev.id = id;
+	ev.arg = arg;
+	ev.data = data;
+	ring.push(ev);
+}
+
+// write every thread's events to fd
+// only makes async-signal-safe calls, so can be used from a signal handler
+// returns false if writing failed, with errno set
+inline bool dump(int fd)
+{
+	namespace detail = flight_recorder_detail;
+
+	detail::file_header file = { { 'F', 'L', 'R', 'C' }, sizeof(flight_event) };
+	struct iovec file_iov = { &file, sizeof(file) };
+	if(!ring_buffer_io_detail::writev_all(fd, &file_iov, 1)) {
+		return false;
+	}
+
+	auto table = detail::slots();
+	for(std::size_t i = 0; i < detail::max_threads; ++i) {
+		auto ring = table[i].ring.load(std::memory_order_acquire);
+		if(ring == nullptr) {
+			continue;
+		}
+
+		auto one = ring->first_segment();
+		auto two = ring->second_segment();
+
+		detail::thread_header hdr = { table[i].thread.load(std::memory_order_acquire), one.second + two.second };
+		struct iovec iov[3] = {
+			{ &hdr, sizeof(hdr) },
+			{ const_cast<flight_event*>(one.first), one.second * sizeof(flight_event) },
+			{ const_cast<flight_event*>(two.first), two.second * sizeof(flight_event) },
+		};
+		if(!ring_buffer_io_detail::writev_all(fd, iov, two.second > 0 ? 3 : 2)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace flight_recorder
+
+namespace flight_recorder_detail {
+
+inline void on_crash(int sig)
+{
+	auto saved = errno;
+	auto fd = crash_fd().load(std::memory_order_relaxed);
+	if(fd >= 0) {
+		flight_recorder::dump(fd);
+	}
+	errno = saved;
+
+	// SA_RESETHAND restored the default action
+	::raise(sig);
+}
+
+} // namespace flight_recorder_detail
+
+namespace flight_recorder {
+
+// dump to fd on SIGSEGV and SIGABRT, then carry on with the default action
+// the handler runs on the alternate signal stack if there is one, so a dump
+// still happens on stack overflow if sigaltstack was set up
+// returns false if a handler couldn't be installed, with errno set
+inline bool install_crash_handler(int fd)
+{
+	flight_recorder_detail::crash_fd().store(fd, std::memory_order_relaxed);
+
+	struct sigaction sa;
+	sa.sa_handler = &flight_recorder_detail::on_crash;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = static_cast<int>(SA_RESETHAND | SA_ONSTACK);
+
+	return ::sigaction(SIGSEGV, &sa, nullptr) == 0
+		&& ::sigaction(SIGABRT, &sa, nullptr) == 0;
+}
+
+} // namespace flight_recorder
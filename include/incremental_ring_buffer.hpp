@@ -0,0 +1,454 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Ring buffer which spreads the cost of growing over later operations.
+ *
+ * When a ring_buffer grows, every value is moved to the new memblk at once,
+ * which stalls that one push for a time proportional to the size. Instead,
+ * incremental_ring_buffer allocates the new memblk and keeps the old one
+ * around. Every push and pop after that moves a few values (step_size) from
+ * the back of the old ring to the front of the new one, until the old ring
+ * is empty and can be freed. This is the same idea as incremental rehashing.
+ *
+ * During a migration the values are the old ring followed by the new ring,
+ * so access by index stays O(1).
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * template <typename T, typename Allocator = std::allocator<T>>
+ * class incremental_ring_buffer
+ * {
+ * public:
+ *
+ *      static constexpr size_type step_size;
+ *
+ *      incremental_ring_buffer();
+ *      explicit incremental_ring_buffer(const allocator_type& alloc);
+ *
+ *      reference operator[](size_type pos);
+ *      reference at(size_type pos);
+ *      reference front();
+ *      reference back();
+ *
+ *      iterator begin();
+ *      iterator end();
+ *
+ *      bool empty() const;
+ *      size_type size() const;
+ *      size_type capacity() const;
+ *      bool migrating() const;
+ *
+ *      reference push_front(const value_type& value); // and T&&, emplace_front
+ *      reference push_back(const value_type& value);  // and T&&, emplace_back
+ *      void pop_front();
+ *      void pop_back();
+ *      void finish_migration();
+ *      void clear();
+ *      void swap(incremental_ring_buffer& other);
+ * };
+ *
+ * \endcode
+ */
+
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "index_iterator.hpp"
+#include "ring_buffer.hpp"
+
+template <typename T, typename Allocator = std::allocator<T>>
+class incremental_ring_buffer
+{
+private: // internal statics
+
+	using ring_type = ring_buffer<T, Allocator>;
+
+public: // statics
+
+	// {{{ member types
+
+	using allocator_type         = typename ring_type::allocator_type;
+	using value_type             = T;
+
+	using size_type              = typename ring_type::size_type;
+	using difference_type        = typename ring_type::difference_type;
+
+	using reference              = value_type&;
+	using const_reference        = const value_type&;
+
+	using pointer                = typename ring_type::pointer;
+	using const_pointer          = typename ring_type::const_pointer;
+
+	// values move between rings, so iterate by index
+	using iterator               = index_iterator<incremental_ring_buffer, pointer>;
+	using const_iterator         = index_iterator<const incremental_ring_buffer, const_pointer>;
+	using reverse_iterator       = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	// }}}
+
+	// values migrated per push or pop
+	// the new ring is at least 1.5x the old one, so with at least 2 per
+	// push, migration always finishes before the new ring fills up
+	static constexpr size_type step_size = 4;
+
+private: // variables
+
+	// values are m_old followed by m_new
+	// m_old is only non-empty while migrating
+	ring_type m_old;
+	ring_type m_new;
+
+private: // internal methods
+
+	// {{{ internal methods
+
+	// move a value from the back of m_old to the front of m_new
+	void migrate_one()
+	{
+		m_new.push_front(std::move_if_noexcept(m_old.back()));
+		m_old.pop_back();
+
+		if(m_old.empty()) {
+			// free the old memblk
+			m_old.release();
+		}
+	}
+
+	// called on each push or pop
+	void migrate_step()
+	{
+		for(size_type i = 0; i < step_size && !m_old.empty(); ++i) {
+			this->migrate_one();
+		}
+	}
+
+	// ring the front value goes in
+	// if migrating, that's m_old
+	ring_type& front_ring()
+	{
+		return m_old.empty() ? m_new : m_old;
+	}
+
+	// make space for one more value in m_new, starting a migration if full
+	void ensure_space_new()
+	{
+		if(m_new.size() < m_new.capacity()) {
+			return;
+		}
+
+		if(!m_old.empty()) {
+			// shouldn't happen (see step_size), but stay correct
+			this->finish_migration();
+		}
+
+		// m_old is empty, so only holds memory if it was never freed
+		auto cap = m_new.capacity();
+		auto new_cap = cap + cap / 2;
+		if(new_cap < cap + 2 * step_size) {
+			new_cap = cap + 2 * step_size;
+		}
+
+		// allocating doesn't touch the values, so is cheap
+		ring_type fresh(new_cap, m_new.get_allocator());
+		m_old.swap(m_new);
+		m_new.swap(fresh);
+	}
+
+	// false if failed
+	bool range_check(size_type pos) const
+	{
+		if(pos >= this->size()) {
+			throw std::out_of_range("incremental_ring_buffer::range_check: pos >= this->size()");
+			return false;
+		}
+		return true;
+	}
+
+	// }}}
+
+public: // methods
+
+	// {{{ basic functions
+
+	incremental_ring_buffer()
+		: incremental_ring_buffer(allocator_type())
+	{
+	}
+
+	explicit incremental_ring_buffer(const allocator_type& alloc)
+		: m_old(alloc), m_new(alloc)
+	{
+	}
+
+	allocator_type get_allocator() const
+	{
+		return m_new.get_allocator();
+	}
+
+	// }}}
+
+	// {{{ element access
+
+	reference at(size_type pos)
+	{
+		this->range_check(pos);
+		return (*this)[pos];
+	}
+
+	const_reference at(size_type pos) const
+	{
+		this->range_check(pos);
+		return (*this)[pos];
+	}
+
+	reference operator[](size_type pos)
+	{
+		// ensure: this->range_check(pos)
+		auto old_size = m_old.size();
+		return pos < old_size ? m_old[pos] : m_new[pos - old_size];
+	}
+
+	const_reference operator[](size_type pos) const
+	{
+		// ensure: this->range_check(pos)
+		auto old_size = m_old.size();
+		return pos < old_size ? m_old[pos] : m_new[pos - old_size];
+	}
+
+	reference front()
+	{
+		// ensure: this->size() > 0
+		return m_old.empty() ? m_new.front() : m_old.front();
+	}
+
+	const_reference front() const
+	{
+		// ensure: this->size() > 0
+		return m_old.empty() ? m_new.front() : m_old.front();
+	}
+
+	reference back()
+	{
+		// ensure: this->size() > 0
+		return m_new.empty() ? m_old.back() : m_new.back();
+	}
+
+	const_reference back() const
+	{
+		// ensure: this->size() > 0
+		return m_new.empty() ? m_old.back() : m_new.back();
+	}
+
+	// }}}
+
+	// {{{ iterators
+
+	iterator begin()
+	{
+		return { this, 0 };
+	}
+
+	const_iterator begin() const
+	{
+		return this->cbegin();
+	}
+
+	const_iterator cbegin() const
+	{
+		return { this, 0 };
+	}
+
+	iterator end()
+	{
+		return { this, this->size() };
+	}
+
+	const_iterator end() const
+	{
+		return this->cend();
+	}
+
+	const_iterator cend() const
+	{
+		return { this, this->size() };
+	}
+
+	reverse_iterator rbegin()
+	{
+		return reverse_iterator(this->end());
+	}
+
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(this->cend());
+	}
+
+	reverse_iterator rend()
+	{
+		return reverse_iterator(this->begin());
+	}
+
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(this->cbegin());
+	}
+
+	// }}}
+
+	// {{{ capacity
+
+	bool empty() const
+	{
+		return this->size() == 0;
+	}
+
+	size_type size() const
+	{
+		return m_old.size() + m_new.size();
+	}
+
+	// values that fit before the next migration starts
+	size_type capacity() const
+	{
+		return m_new.capacity();
+	}
+
+	// is there still an old memblk with values in it
+	bool migrating() const
+	{
+		return !m_old.empty();
+	}
+
+	// }}}
+
+	// {{{ modifiers
+
+	// move all remaining values, e.g. before a latency-sensitive section
+	// invalidates: all (if migrating)
+	void finish_migration()
+	{
+		while(!m_old.empty()) {
+			this->migrate_one();
+		}
+	}
+
+	// invalidates: all
+	void clear()
+	{
+		m_old.release();
+		m_new.clear();
+	}
+
+	// invalidates: all
+	reference push_front(const value_type& value)
+	{
+		return this->emplace_front(value);
+	}
+
+	// invalidates: all
+	reference push_front(value_type&& value)
+	{
+		return this->emplace_front(std::move(value));
+	}
+
+	// invalidates: all
+	template <typename... Args>
+	reference emplace_front(Args&&... args)
+	{
+		if(m_old.empty()) {
+			// may start a migration, with m_old full
+			this->ensure_space_new();
+		}
+
+		if(!m_old.empty() && m_old.size() == m_old.capacity()) {
+			// migration frees space at the back of m_old, but args may
+			// refer to the value it moves, so construct first
+			value_type value(std::forward<Args>(args)...);
+			this->migrate_one();
+			this->front_ring().emplace_front(std::move(value));
+		} else {
+			this->front_ring().emplace_front(std::forward<Args>(args)...);
+		}
+
+		// after, since migrating moves the values args may refer to
+		this->migrate_step();
+		return this->front();
+	}
+
+	// invalidates: all
+	void pop_front()
+	{
+		// ensure: this->size() > 0
+		this->migrate_step();
+		if(m_old.empty()) {
+			m_new.pop_front();
+		} else {
+			m_old.pop_front();
+			if(m_old.empty()) {
+				m_old.release();
+			}
+		}
+	}
+
+	// invalidates: all
+	reference push_back(const value_type& value)
+	{
+		return this->emplace_back(value);
+	}
+
+	// invalidates: all
+	reference push_back(value_type&& value)
+	{
+		return this->emplace_back(std::move(value));
+	}
+
+	// invalidates: all
+	template <typename... Args>
+	reference emplace_back(Args&&... args)
+	{
+		this->ensure_space_new();
+		m_new.emplace_back(std::forward<Args>(args)...);
+
+		// after, since migrating moves the values args may refer to
+		this->migrate_step();
+		return this->back();
+	}
+
+	// invalidates: all
+	void pop_back()
+	{
+		// ensure: this->size() > 0
+		this->migrate_step();
+		if(m_new.empty()) {
+			m_old.pop_back();
+			if(m_old.empty()) {
+				m_old.release();
+			}
+		} else {
+			m_new.pop_back();
+		}
+	}
+
+	void swap(incremental_ring_buffer& other)
+	{
+		m_old.swap(other.m_old);
+		m_new.swap(other.m_new);
+	}
+
+	// }}}
+
+	friend void swap(incremental_ring_buffer& lhs, incremental_ring_buffer& rhs)
+	{
+		lhs.swap(rhs);
+	}
+
+};
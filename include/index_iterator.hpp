@@ -0,0 +1,181 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Random access iterator which refers to a value by its index in a container.
+ *
+ * Dereferencing goes through the container's operator[], so the iterator
+ * stays valid as long as the value keeps its index, even if the container
+ * moves its storage around. This suits containers whose values are not in
+ * one block of memory (e.g. chunked_ring_buffer).
+ *
+ * note: Owner is the container type, const-qualified for a const iterator.
+ *       operator-> is only usable when the container's references are real
+ *       references.
+ */
+
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+template <typename Owner, typename P>
+class index_iterator
+{ // {{{ impl
+private: // internal statics
+
+	using container = typename std::remove_const<Owner>::type;
+	using size_type = typename container::size_type;
+
+	template <typename O2, typename P2>
+	friend class index_iterator;
+
+public: // statics
+
+	using iterator_category = std::random_access_iterator_tag;
+	using value_type        = typename container::value_type;
+	using difference_type   = typename container::difference_type;
+	using pointer           = P;
+	// the container's references, which may be proxies (e.g. soa_ring_buffer)
+	using reference         = typename std::conditional<std::is_const<Owner>::value,
+	                                                    typename container::const_reference,
+	                                                    typename container::reference>::type;
+
+private: // variables
+
+	Owner* owner;
+	size_type idx;
+
+public: // methods
+
+	/// default constructor, iterator not associated with any container
+	index_iterator()
+		: owner(nullptr), idx(0)
+	{
+	}
+
+	/// construct from a container and an index into it
+	index_iterator(Owner* i_owner, size_type i_idx)
+		: owner(i_owner), idx(i_idx)
+	{
+	}
+
+	/// convert, used to convert iterator to const_iterator
+	template <typename O2, typename P2,
+	          typename = typename std::enable_if<std::is_convertible<O2*, Owner*>::value>::type>
+	index_iterator(const index_iterator<O2, P2>& other)
+		: owner(other.owner), idx(other.idx)
+	{
+	}
+
+	/// index of the value referred to
+	size_type index() const
+	{
+		return idx;
+	}
+
+	reference operator*() const
+	{
+		return (*owner)[idx];
+	}
+
+	pointer operator->() const
+	{
+		return std::addressof((*owner)[idx]);
+	}
+
+	reference operator[](difference_type n) const
+	{
+		return *(*this + n);
+	}
+
+	index_iterator& operator++()
+	{
+		++idx;
+		return *this;
+	}
+
+	index_iterator operator++(int)
+	{
+		auto cpy = *this;
+		++idx;
+		return cpy;
+	}
+
+	index_iterator& operator--()
+	{
+		--idx;
+		return *this;
+	}
+
+	index_iterator operator--(int)
+	{
+		auto cpy = *this;
+		--idx;
+		return cpy;
+	}
+
+	index_iterator& operator+=(difference_type n)
+	{
+		idx = static_cast<size_type>(static_cast<difference_type>(idx) + n);
+		return *this;
+	}
+
+	index_iterator& operator-=(difference_type n)
+	{
+		return *this += -n;
+	}
+
+	friend index_iterator operator+(index_iterator it, difference_type n)
+	{
+		return it += n;
+	}
+
+	friend index_iterator operator+(difference_type n, index_iterator it)
+	{
+		return it += n;
+	}
+
+	friend index_iterator operator-(index_iterator it, difference_type n)
+	{
+		return it -= n;
+	}
+
+	// as with radix_iterator, the owners are not compared
+
+	friend difference_type operator-(const index_iterator& lhs, const index_iterator& rhs)
+	{
+		return static_cast<difference_type>(lhs.idx) - static_cast<difference_type>(rhs.idx);
+	}
+
+	friend bool operator==(const index_iterator& lhs, const index_iterator& rhs)
+	{
+		return lhs.idx == rhs.idx;
+	}
+
+	friend bool operator!=(const index_iterator& lhs, const index_iterator& rhs)
+	{
+		return lhs.idx != rhs.idx;
+	}
+
+	friend bool operator<(const index_iterator& lhs, const index_iterator& rhs)
+	{
+		return lhs.idx < rhs.idx;
+	}
+
+	friend bool operator>(const index_iterator& lhs, const index_iterator& rhs)
+	{
+		return lhs.idx > rhs.idx;
+	}
+
+	friend bool operator<=(const index_iterator& lhs, const index_iterator& rhs)
+	{
+		return lhs.idx <= rhs.idx;
+	}
+
+	friend bool operator>=(const index_iterator& lhs, const index_iterator& rhs)
+	{
+		return lhs.idx >= rhs.idx;
+	}
+
+}; // }}}
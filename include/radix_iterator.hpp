@@ -233,26 +233,6 @@ public: // methods
 		return current;
 	}
 
-	// no need to check underlying range
-	// as dictated by the standard (for BidiIterator)
-
-	template <typename L, typename R>
-	friend constexpr
-	bool operator==(const radix_iterator<L>& lhs, const radix_iterator<R>& rhs)
-		noexcept(noexcept(lhs.current == rhs.current))
-	{
-		// ensure: lhs.front == rhs.front, lhs.back == rhs.back
-		return lhs.current == rhs.current;
-	}
-
-	template <typename L, typename R>
-	friend constexpr
-	bool operator!=(const radix_iterator<L>& lhs, const radix_iterator<R>& rhs)
-		noexcept(noexcept(lhs.current == rhs.current))
-	{
-		return !(lhs == rhs);
-	}
-
 	// convert
 	// used to convert iterator to const_iterator
 	template <typename P2>
@@ -265,3 +245,25 @@ public: // methods
 	}
 
 }; // }}}
+
+// no need to check underlying range
+// as dictated by the standard (for BidiIterator)
+
+// non-member, so that mixed comparisons (e.g. iterator with const_iterator)
+// do not redefine a friend for each instantiation
+template <typename L, typename R>
+constexpr
+bool operator==(const radix_iterator<L>& lhs, const radix_iterator<R>& rhs)
+	noexcept(noexcept(lhs.get() == rhs.get()))
+{
+	// ensure: lhs.begin() == rhs.begin(), lhs.end() == rhs.end()
+	return lhs.get() == rhs.get();
+}
+
+template <typename L, typename R>
+constexpr
+bool operator!=(const radix_iterator<L>& lhs, const radix_iterator<R>& rhs)
+	noexcept(noexcept(lhs == rhs))
+{
+	return !(lhs == rhs);
+}
@@ -2,16 +2,117 @@
 
 // TODO(timmy): reduce header dependencies
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring> // for memmove
+#include <functional> // for less, to compare unrelated pointers
 #include <initializer_list>
 #include <iterator>
+#include <limits>
 #include <memory>
-#include <stdexcept> // only for out_of_range (used once, but required)
+#include <stdexcept> // for out_of_range and length_error
 #include <type_traits>
 #include <utility>
 
 #include "radix_iterator.hpp"
 
-template <typename T, typename Allocator = std::allocator<T>>
+// {{{ shrink policies
+
+// ShrinkPolicy decides when a ring gives memory back on its own. after each
+// push and pop, should_shrink(size, capacity) is asked, and if it returns
+// true, the capacity is halved
+
+// never shrink, memory is only freed by shrink_to_fit() or release()
+struct ring_buffer_keep_capacity
+{
+	bool should_shrink(std::size_t /* size */, std::size_t /* cap */)
+	{
+		return false;
+	}
+};
+
+// shrink once size has stayed below LowNum / LowDen of the capacity for
+// `Ops' operations in a row. waiting stops a ring which is briefly emptied
+// and refilled from reallocating every time
+template <std::size_t LowNum = 1, std::size_t LowDen = 4, std::size_t Ops = 1024>
+struct ring_buffer_shrink_hysteresis
+{
+	static_assert(LowNum * 2 <= LowDen, "low-water mark must be at most half, so values fit after halving");
+
+	std::size_t below = 0;
+
+	bool should_shrink(std::size_t size, std::size_t cap)
+	{
+		if(size * LowDen >= cap * LowNum) {
+			below = 0;
+			return false;
+		}
+		if(++below < Ops) {
+			return false;
+		}
+		below = 0;
+		return true;
+	}
+};
+
+// }}}
+
+// {{{ watermarks
+
+// Watermark is told whenever the size changes, with on_size(old, new), so it
+// can tell producers to back off before a ring gets too big, rather than
+// them polling size(). unlike the shrink policy, it belongs to the ring
+// object, and isn't copied, moved or swapped along with the values
+
+// no thresholds, so costs nothing
+struct ring_buffer_no_watermark
+{
+	void on_size(std::size_t /* old_size */, std::size_t /* new_size */)
+	{
+	}
+};
+
+// call on_high when the size rises to `high' or above, and on_low when it
+// falls to `low' or below. each fires once per crossing, not on every change
+// past the threshold, so e.g. on_high can pause producers and on_low resume
+// them. see ring_buffer_eventfd_notify for notifying through an eventfd
+struct ring_buffer_watermark
+{
+	std::size_t high = std::numeric_limits<std::size_t>::max();
+	std::size_t low = 0;
+	std::function<void()> on_high;
+	std::function<void()> on_low;
+
+	void on_size(std::size_t old_size, std::size_t new_size)
+	{
+		if(on_high && old_size < high && new_size >= high) {
+			on_high();
+		}
+		if(on_low && old_size > low && new_size <= low) {
+			on_low();
+		}
+	}
+};
+
+// }}}
+
+// locks the head and tail of a ring_buffer separately, see
+// concurrent_ring_buffer.hpp
+template <typename T, typename Allocator, typename Watermark>
+class concurrent_ring_buffer;
+
+// fills the free space of byte rings in place, see ring_buffer_io.hpp
+namespace ring_buffer_io_detail {
+struct ring_access;
+}
+
+// Index is the type used to store offsets into the memblk. it can be made
+// smaller than size_type (e.g. std::uint32_t) to shrink the ring itself,
+// at the cost of a lower max_size()
+template <typename T, typename Allocator = std::allocator<T>,
+          typename Index = typename std::allocator_traits<Allocator>::size_type,
+          typename ShrinkPolicy = ring_buffer_keep_capacity,
+          typename Watermark = ring_buffer_no_watermark>
 class ring_buffer
 {
 private: // internal statics
@@ -22,6 +123,9 @@ private: // internal statics
 	static_assert(std::is_same<T, typename atraits::value_type>::value,
 	              "Allocator must use the same type as T");
 
+	static_assert(std::is_unsigned<Index>::value,
+	              "Index must be an unsigned integer type");
+
 	// allocator weirdness
 	using pocca = std::integral_constant<bool, atraits::propagate_on_container_copy_assignment::value>;
 	using pocma = std::integral_constant<bool, atraits::propagate_on_container_move_assignment::value>;
@@ -36,6 +140,9 @@ public: // statics
 
 	using size_type              = typename atraits::size_type;
 	using difference_type        = typename atraits::difference_type;
+	using index_type             = Index;
+	using shrink_policy          = ShrinkPolicy;
+	using watermark_type         = Watermark;
 
 	using reference              = value_type&;
 	using const_reference        = const value_type&;
@@ -63,6 +170,15 @@ private: // internal statics
 			>::value,
 		int>::type;
 
+	// values which can be relocated and filled with raw memory operations
+	using is_trivial = std::integral_constant<bool, std::is_trivially_copyable<T>::value>;
+
+	// values which need no destruction
+	using is_trivial_dtor = std::integral_constant<bool, std::is_trivially_destructible<T>::value>;
+
+	// values which need no default initialisation
+	using is_trivial_ctor = std::integral_constant<bool, std::is_trivially_default_constructible<T>::value>;
+
 	// expansion rate
 	// 1.5 is more optimal than 2,
 	// best would be psi (golden ratio) ~= 1.68, but 1.5 is close enough
@@ -76,30 +192,33 @@ private: // internal statics
 		return size_type((val % wrap_s) + wrap_s) % wrap;
 	}
 
-	// defined at bottom, resolves dependency on interface
-	static void destruct_memblk(ring_buffer* self, pointer ptr);
-
-	struct mb_dtor
+	// the memblk, stored along with the allocator, shrink policy and
+	// watermark. deriving from them lets empty ones take up no space
+	// (empty base optimisation)
+	struct mb_holder : allocator_type, shrink_policy, watermark_type
 	{
-		using pointer = ring_buffer::pointer;
+		pointer ptr;
+
+		mb_holder(const allocator_type& alloc, pointer i_ptr)
+			noexcept
+			: allocator_type(alloc), shrink_policy(), watermark_type(), ptr(i_ptr)
+		{
+		}
 
-		ring_buffer* self;
+		mb_holder(allocator_type&& alloc, pointer i_ptr)
+			noexcept
+			: allocator_type(std::move(alloc)), shrink_policy(), watermark_type(), ptr(i_ptr)
+		{
+		}
 
-		// destroy all and free
-		void operator()(pointer ptr)
+		pointer get() const
 		{
-			destruct_memblk(self, ptr);
+			return ptr;
 		}
-	};
 
-	// small implementation
-	// removes <functional> dependency for reference_wrapper in insert
-	struct cref_wrapper
-	{
-		const value_type* ptr;
-		operator const value_type&() const
+		reference operator[](size_type idx) const
 		{
-			return *ptr;
+			return ptr[idx];
 		}
 	};
 
@@ -109,42 +228,99 @@ private: // internal statics
 	using abs_offset_rel = difference_type;
 	using idx_offset_rel = difference_type;
 
+	// works on the ends separately, keeping them consistent itself
+	template <typename, typename, typename>
+	friend class concurrent_ring_buffer;
+
+	// reads straight into the free space, then commits it
+	friend struct ring_buffer_io_detail::ring_access;
+
 private: // variables
 
 	// note: we always need one blank element. otherwise, we can't
 	//       distinguish between a blank ring and one with all values
 	//       allocated
 
-	allocator_type mm; // `memory manager'
-	// raw memblks
-	size_type mb_size;
-	std::unique_ptr<T[], mb_dtor> memblk;
+	// raw memblk + `memory manager'
+	mb_holder memblk;
+	index_type mb_size;
 
 	// begin and end idx of values
-	size_type m_begin;
-	size_type m_end;
+	index_type m_begin;
+	index_type m_end;
 
 private: // internal methods
 
 	// {{{ internal methods
 
-	// create a mb_dtor object
-	mb_dtor make_mb_dtor()
+	// `memory manager'
+	allocator_type& mm()
+		noexcept
+	{
+		return memblk;
+	}
+
+	const allocator_type& mm() const
 		noexcept
 	{
-		return {this};
+		return memblk;
+	}
+
+	shrink_policy& policy()
+		noexcept
+	{
+		return memblk;
+	}
+
+	// tell the watermark, after the size may have changed
+	void size_changed(size_type old_size)
+	{
+		static_cast<watermark_type&>(memblk).on_size(old_size, this->size());
+	}
+
+	// swap everything but the watermark, without telling it
+	// for moving values to a new memblk, which keeps the size
+	void swap_values(ring_buffer& other)
+	{
+		// for adl
+		using std::swap;
+
+		this->swap_mm(other, pocs());
+		swap(memblk.ptr, other.memblk.ptr);
+		swap(mb_size, other.mb_size);
+		swap(m_begin, other.m_begin);
+		swap(m_end, other.m_end);
+		swap(this->policy(), other.policy());
 	}
 
 	// destruct all objects
 	void dtor_value(abs_offset idx)
 	{
-		atraits::destroy(mm, &memblk[this->abs_offset_of(idx)]);
+		atraits::destroy(this->mm(), memblk.get() + this->abs_offset_of(idx));
 	}
 
 	void dtor_value(abs_offset begin, abs_offset end)
 	{
-		for(auto idx = begin; idx != end; idx = (idx + 1) % mb_size) {
-			this->dtor_value(idx);
+		this->dtor_value(begin, end, is_trivial_dtor());
+	}
+
+	// tag dispatch
+	// nothing to do for trivially destructible values
+	void dtor_value(abs_offset /* begin */, abs_offset /* end */, std::true_type /* trivial dtor */)
+	{
+	}
+
+	void dtor_value(abs_offset begin, abs_offset end, std::false_type /* trivial dtor */)
+	{
+		// at most two segments
+		if(begin > end) {
+			for(; begin != mb_size; ++begin) {
+				atraits::destroy(this->mm(), this->ptr_of(begin));
+			}
+			begin = 0;
+		}
+		for(; begin != end; ++begin) {
+			atraits::destroy(this->mm(), this->ptr_of(begin));
 		}
 	}
 
@@ -155,16 +331,31 @@ private: // internal methods
 	}
 
 	// allocate a memory block
-	std::unique_ptr<T[], mb_dtor> alloc_memblk(size_type size)
+	// size is the capacity + 1, so is 0 if that overflowed
+	pointer alloc_memblk(size_type size)
 	{
-		return { atraits::allocate(mm, size), this->make_mb_dtor() };
+		if(size == 0 || size - 1 > this->max_size()) {
+			throw std::length_error("ring_buffer::alloc_memblk: capacity > this->max_size()");
+		}
+		return atraits::allocate(this->mm(), size);
+	}
+
+	// destroy all values and free the memory block
+	void free_memblk()
+	{
+		this->dtor_value_all();
+		if(memblk.ptr != nullptr) {
+			atraits::deallocate(this->mm(), memblk.ptr, mb_size);
+		}
+		memblk.ptr = nullptr;
+		mb_size = 0;
 	}
 
 	// construct element
 	template <typename... Args>
 	void ctor_value(abs_offset idx, Args&&... args)
 	{
-		atraits::construct(mm, memblk.get() + idx, std::forward<Args>(args)...);
+		atraits::construct(this->mm(), memblk.get() + idx, std::forward<Args>(args)...);
 	}
 
 	// tag dispatch
@@ -172,10 +363,10 @@ private: // internal methods
 	// and we need different code because of this
 	void move_assign_mm(ring_buffer& other, std::true_type /* pocma */)
 	{
-		mm = std::move(other.mm);
+		this->mm() = std::move(other.mm());
 	}
 
-	void move_assign_mm(ring_buffer& other, std::false_type /* pocma */)
+	void move_assign_mm(ring_buffer& /* other */, std::false_type /* pocma */)
 	{
 		// do nothing
 	}
@@ -183,25 +374,28 @@ private: // internal methods
 	void move_assign(ring_buffer&& other, std::true_type /* pocma */)
 	{
 		// 1. deallocate
-		memblk.reset();
+		this->free_memblk();
 
 		// 2. move allocator
 		this->move_assign_mm(other, pocma());
 
 		// 3. transfer ownership
-		memblk = std::move(other.memblk);
-		memblk.get_deleter() = this->make_mb_dtor();
+		memblk.ptr = other.memblk.ptr;
 		mb_size = other.mb_size;
+		other.memblk.ptr = nullptr;
 
 		// other members
 		m_begin = other.m_begin;
 		m_end = other.m_end;
+
+		// leave other blank
+		other.mb_size = other.m_begin = other.m_end = 0;
 	}
 
 	void move_assign(ring_buffer&& other, std::false_type /* pocma */)
 	{
-		if(mm == other.mm) {
-			move_assign(other, std::true_type());
+		if(this->mm() == other.mm()) {
+			move_assign(std::move(other), std::true_type());
 		} else {
 			this->assign(std::make_move_iterator(other.begin()),
 				     std::make_move_iterator(other.end()));
@@ -210,10 +404,10 @@ private: // internal methods
 
 	void copy_assign_mm(const ring_buffer& other, std::true_type /* pocca */)
 	{
-		mm = other.mm;
+		this->mm() = other.mm();
 	}
 
-	void copy_assign_mm(const ring_buffer& other, std::false_type /* pocca */)
+	void copy_assign_mm(const ring_buffer& /* other */, std::false_type /* pocca */)
 	{
 		// do nothing
 	}
@@ -221,10 +415,10 @@ private: // internal methods
 	void swap_mm(ring_buffer& other, std::true_type /* pocs */)
 	{
 		using std::swap;
-		swap(mm, other.mm);
+		swap(this->mm(), other.mm());
 	}
 
-	void swap_mm(ring_buffer& other, std::false_type /* pocs */)
+	void swap_mm(ring_buffer& /* other */, std::false_type /* pocs */)
 	{
 		// ensure: mm == other.mm
 		// do nothing
@@ -234,58 +428,132 @@ private: // internal methods
 	{
 		this->dtor_value_all();
 		if(count > this->capacity()) {
-			memblk = this->alloc_memblk(count);
-			mb_size = count + 1;
-
-			m_begin = 0;
-			m_end = count + 1;
+			this->free_memblk();
+			memblk.ptr = this->alloc_memblk(count + 1);
+			mb_size = static_cast<index_type>(count + 1);
 		}
+
+		// [m_begin, m_end) is left uninitialised
+		m_begin = 0;
+		m_end = static_cast<index_type>(count);
 	}
 
 	void ensure_alloc_blanked_extra(size_type count)
 	{
 		size_type new_size = count;
 		if(count > this->capacity()) {
-			// no rounding needed
-			// if size not enough, it is increased to count
-			new_size = mb_size * expansion_ratio;
-			if(count > new_size) {
-				new_size = count;
-			}
+			new_size = this->extra_capacity(count);
 		}
 		this->ensure_alloc_blanked(new_size);
 	}
 
+	// move `count' values from index `from' into new_blk at index `to'
+	void ctor_values_into(ring_buffer& new_blk, idx_offset from, idx_offset to, size_type count)
+	{
+		while(count > 0) {
+			auto src = this->offset_of(from);
+			auto seg = std::min(count, mb_size - src);
+			for(size_type i = 0; i < seg; ++i) {
+				// new_blk begins at 0, so no wrapping needed
+				new_blk.ctor_value(to + i, std::move_if_noexcept(memblk[src + i]));
+			}
+
+			from += seg;
+			to += seg;
+			count -= seg;
+		}
+	}
+
+	// move all values to a new memblk with capacity `cap'
+	void realloc_copy(size_type cap)
+	{
+		// ensure: cap >= this->size()
+		ring_buffer new_blk(cap, this->mm());
+		this->ctor_values_into(new_blk, 0, 0, this->size());
+		new_blk.m_end = static_cast<index_type>(this->size());
+
+		this->swap_values(new_blk);
+	}
+
+	// ask the shrink policy, after a push or pop
+	// halving moves the values with realloc_copy, as shrink_to_fit does
+	void auto_shrink()
+	{
+		auto cap = this->capacity();
+		if(cap == 0 || !this->policy().should_shrink(this->size(), cap)) {
+			return;
+		}
+
+		if(cap / 2 < this->size()) {
+			// policy asked for too much
+			return;
+		}
+		if(cap / 2 == 0) {
+			this->free_memblk();
+		} else {
+			this->realloc_copy(cap / 2);
+		}
+	}
+
 	void ensure_alloc_copy(size_type count)
 	{
 		if(count > this->capacity()) { // implies count > this->size()
-			ring_buffer new_blk(count);
-			new_blk.m_begin = 0;
-			new_blk.m_end = this->size();
-
-			for(auto own_it = this->begin(), new_it = new_blk.begin();
-			    own_it != this->end() && new_it != new_blk.end();
-			    ++own_it, ++new_it) {
-				// init from old
-				new_blk.ctor_value(new_blk.it_offset(new_it), std::move_if_noexcept(*own_it));
-			}
+			this->realloc_copy(count);
+		}
+	}
 
-			this->swap(new_blk);
+	// capacity to grow to, to fit at least count
+	size_type extra_capacity(size_type count) const
+	{
+		// no rounding needed
+		// if size not enough, it is increased to count
+		auto new_size = static_cast<size_type>(static_cast<double>(mb_size) * expansion_ratio);
+
+		// growing past max_size() is only an error if count needs it
+		if(new_size > this->max_size()) {
+			new_size = this->max_size();
 		}
+		return count > new_size ? count : new_size;
 	}
 
 	void ensure_alloc_copy_extra(size_type count)
 	{
-		size_type new_size = count;
 		if(count > this->capacity()) {
-			// see above (ensure_alloc_blanked_extra) for explanation
-			// on the lack of rounding
-			new_size = static_cast<size_type>(mb_size * expansion_ratio);
-			if(count > new_size) {
-				new_size = count;
-			}
+			this->ensure_alloc_copy(this->extra_capacity(count));
 		}
-		this->ensure_alloc_copy(new_size);
+	}
+
+	// logic for emplace_front() and emplace_back() when full
+	// the new value is constructed before the old ones are moved,
+	// so args may refer to a value in this ring
+	template <typename... Args>
+	void realloc_emplace(idx_offset idx, Args&&... args)
+	{
+		auto old_size = this->size();
+		ring_buffer new_blk(this->extra_capacity(old_size + 1), this->mm());
+		new_blk.ctor_value(idx, std::forward<Args>(args)...);
+
+		this->ctor_values_into(new_blk, 0, 0, idx);
+		this->ctor_values_into(new_blk, idx, idx + 1, old_size - idx);
+		new_blk.m_end = static_cast<index_type>(old_size + 1);
+
+		this->swap_values(new_blk);
+	}
+
+	// index of value if it is in this ring, otherwise size()
+	idx_offset idx_of_value(const value_type& value) const
+	{
+		if(mb_size == 0) {
+			return this->size();
+		}
+
+		std::less<const value_type*> less;
+		auto ptr = std::addressof(value);
+		auto first = std::addressof(memblk[0]);
+		if(less(ptr, first) || !less(ptr, first + mb_size)) {
+			return this->size();
+		}
+		return this->idx_of(static_cast<abs_offset>(ptr - first));
 	}
 
 	idx_offset idx_of(abs_offset_rel off) const
@@ -348,58 +616,342 @@ private: // internal methods
 		return { memblk.get(), memblk.get() + mb_size, memblk.get() + idx };
 	}
 
-	// logic for this->resize()
+	// iterator to an index, valid even with no memblk
+	iterator it_at(idx_offset idx)
+	{
+		return this->it_of(mb_size == 0 ? 0 : this->offset_of(idx));
+	}
+
+	// index of an iterator, valid even with no memblk
+	template <typename U>
+	idx_offset it_idx(radix_iterator<U> it) const
+	{
+		return mb_size == 0 ? 0 : this->idx_of(this->it_offset(it));
+	}
+
+	pointer ptr_of(abs_offset idx) const
+	{
+		return memblk.get() + idx;
+	}
+
+	// {offset, count} of the first (0) or second (1) segment of values
+	std::pair<abs_offset, size_type> segment_bounds(int which) const
+	{
+		bool wraps = m_end < m_begin;
+		if(which == 0) {
+			return { m_begin, (wraps ? mb_size : m_end) - m_begin };
+		}
+		return { wraps ? 0 : m_end, wraps ? m_end : 0 };
+	}
+
+	// {offset, count} of the first (0) or second (1) run of free space after
+	// the back, not counting the blank value
+	std::pair<abs_offset, size_type> free_bounds(int which) const
+	{
+		auto free = this->capacity() - this->size();
+		auto first = std::min<size_type>(free, mb_size - m_end);
+		if(which == 0) {
+			return { m_end, first };
+		}
+		return { 0, free - first };
+	}
+
+	// the count values after the back have been constructed in the free
+	// space, so add them to the ring
+	void commit_back(size_type count)
+	{
+		if(count == 0) {
+			return;
+		}
+		auto old_size = this->size();
+		m_end = static_cast<index_type>(this->abs_offset_of(m_end + count));
+		this->size_changed(old_size);
+	}
+
+	// raw address of a value, for memmove
+	static void* raw_ptr(pointer ptr)
+	{
+		return static_cast<void*>(std::addressof(*ptr));
+	}
+
+	// tag dispatch
+	// trivially copyable values can be relocated with memmove,
+	// skipping the usual move + destroy
+	void move_segment(pointer first, pointer last, pointer dest, std::true_type /* trivial */)
+	{
+		if(first != last) {
+			std::memmove(raw_ptr(dest), raw_ptr(first), static_cast<size_type>(last - first) * sizeof(T));
+		}
+	}
+
+	void move_segment(pointer first, pointer last, pointer dest, std::false_type /* trivial */)
+	{
+		std::move(first, last, dest);
+	}
+
+	void move_segment_backward(pointer first, pointer last, pointer dest_last, std::true_type /* trivial */)
+	{
+		this->move_segment(first, last, dest_last - (last - first), std::true_type());
+	}
+
+	void move_segment_backward(pointer first, pointer last, pointer dest_last, std::false_type /* trivial */)
+	{
+		std::move_backward(first, last, dest_last);
+	}
+
+	// move `count' values from index `from' to index `to', where to < from.
+	// done a contiguous segment at a time, so there are at most three moves
+	// note: move-assigns, so destination must be initialised (unless trivial)
+	template <typename Trivial>
+	void move_values_down(idx_offset from, idx_offset to, size_type count, Trivial trivial)
+	{
+		while(count > 0) {
+			auto src = this->offset_of(from);
+			auto dst = this->offset_of(to);
+
+			auto seg = std::min(count, std::min(mb_size - src, mb_size - dst));
+			this->move_segment(this->ptr_of(src), this->ptr_of(src + seg), this->ptr_of(dst), trivial);
+
+			from += seg;
+			to += seg;
+			count -= seg;
+		}
+	}
+
+	void move_values_down(idx_offset from, idx_offset to, size_type count)
+	{
+		this->move_values_down(from, to, count, std::false_type());
+	}
+
+	// move `count' values from index `from' to index `to', where to > from.
+	// as above, but starting from the back
+	template <typename Trivial>
+	void move_values_up(idx_offset from, idx_offset to, size_type count, Trivial trivial)
+	{
+		while(count > 0) {
+			// one past the last value of each segment, in [1, mb_size]
+			auto src_end = this->offset_of(from + count - 1) + 1;
+			auto dst_end = this->offset_of(to + count - 1) + 1;
+
+			auto seg = std::min(count, std::min(src_end, dst_end));
+			this->move_segment_backward(this->ptr_of(src_end - seg), this->ptr_of(src_end), this->ptr_of(dst_end), trivial);
+
+			count -= seg;
+		}
+	}
+
+	void move_values_up(idx_offset from, idx_offset to, size_type count)
+	{
+		this->move_values_up(from, to, count, std::false_type());
+	}
+
+	// move-construct `count' values from index `from' into the uninitialised
+	// values at index `to'. the two ranges must not overlap
+	void ctor_values_moved(idx_offset from, idx_offset to, size_type count)
+	{
+		while(count > 0) {
+			auto src = this->offset_of(from);
+			auto dst = this->offset_of(to);
+
+			auto seg = std::min(count, std::min(mb_size - src, mb_size - dst));
+			for(size_type i = 0; i < seg; ++i) {
+				this->ctor_value(dst + i, std::move(memblk[src + i]));
+			}
+
+			from += seg;
+			to += seg;
+			count -= seg;
+		}
+	}
+
+	// construct `count' values at index `idx', over at most two segments
 	template <typename... Args>
-	void resize_val(size_type count, Args&&... args)
+	void ctor_values(idx_offset idx, size_type count, const Args&... args)
 	{
-		if(count > this->size()) {
-			this->ensure_alloc_copy_extra(count);
+		while(count > 0) {
+			auto dst = this->offset_of(idx);
+			auto seg = std::min(count, mb_size - dst);
+			for(size_type i = 0; i < seg; ++i) {
+				this->ctor_value(dst + i, args...);
+			}
+
+			idx += seg;
+			count -= seg;
+		}
+	}
+
+	// copy-assign value over `count' values at index `idx'
+	void fill_values(idx_offset idx, size_type count, const value_type& value)
+	{
+		while(count > 0) {
+			auto dst = this->offset_of(idx);
+			auto seg = std::min(count, mb_size - dst);
+			std::fill_n(this->ptr_of(dst), seg, value);
+
+			idx += seg;
+			count -= seg;
+		}
+	}
+
+	// copy-construct `count' values at index `idx', over at most two segments
+	void ctor_values_fill(idx_offset idx, size_type count, const value_type& value, std::true_type /* trivial */)
+	{
+		while(count > 0) {
+			auto dst = this->offset_of(idx);
+			auto seg = std::min(count, mb_size - dst);
+			std::uninitialized_fill_n(std::addressof(memblk[dst]), seg, value);
+
+			idx += seg;
+			count -= seg;
+		}
+	}
 
-			auto it_old_end = this->end();
-			m_end = this->offset_of(count); // one past the end
+	void ctor_values_fill(idx_offset idx, size_type count, const value_type& value, std::false_type /* trivial */)
+	{
+		this->ctor_values(idx, count, value);
+	}
 
-			for(auto it == it_old_end; it != this->end(); ++it) {
-				this->ctor_value(this->it_offset(it), std::forward<Args>(args)...); // default init
+	// move values in [first, last) which don't match pred to write,
+	// wrapping write around the memblk. returns the new write position
+	template <typename Pred>
+	pointer compact_values(pointer first, pointer last, pointer write, Pred& pred, std::false_type /* trivially copyable */)
+	{
+		for(; first != last; ++first) {
+			if(!pred(*first)) {
+				if(write != first) {
+					*write = std::move(*first);
+				}
+				if(++write == this->ptr_of(mb_size)) {
+					write = this->ptr_of(0);
+				}
 			}
-		} else if(count < this->size()) {
-			auto old_end = m_end;
-			m_end = this->abs_offset_of(m_begin + count);
+		}
+		return write;
+	}
 
-			this->dtor_value(m_end, old_end);
+	// branchless, always copy and only advance write for kept values.
+	// write never passes first, so nothing unread is overwritten
+	template <typename Pred>
+	pointer compact_values(pointer first, pointer last, pointer write, Pred& pred, std::true_type /* trivially copyable */)
+	{
+		for(; first != last; ++first) {
+			bool keep = !pred(*first);
+			*write = *first;
+			write += keep;
+			if(write == this->ptr_of(mb_size)) {
+				write = this->ptr_of(0);
+			}
 		}
+		return write;
+	}
+
+	// logic for erase_if()
+	template <typename Pred>
+	size_type erase_values_if(Pred& pred)
+	{
+		if(this->empty()) {
+			return 0;
+		}
+
+		// values form at most two segments: [m_begin, mb_size) and [0, m_end)
+		bool wraps = m_end < m_begin;
+		auto write = this->compact_values(this->ptr_of(m_begin), this->ptr_of(wraps ? mb_size : m_end),
+		                                  this->ptr_of(m_begin), pred, is_trivial());
+		if(wraps) {
+			write = this->compact_values(this->ptr_of(0), this->ptr_of(m_end), write, pred, is_trivial());
+		}
+
+		auto new_end = this->abs_offset_of(static_cast<abs_offset>(write - this->ptr_of(0)));
+		auto removed = this->size() - this->idx_of(new_end);
+
+		this->dtor_value(new_end, m_end);
+		m_end = static_cast<index_type>(new_end);
+
+		return removed;
+	}
+
+	// logic for resize()
+	// grows to `count' values, leaving new ones uninitialised until
+	// the caller constructs them and sets m_end to offset_of(count)
+	// returns the old size
+	size_type resize_uninit(size_type count)
+	{
+		auto old_size = this->size();
+		this->ensure_alloc_copy_extra(count);
+		return old_size;
 	}
 
-	iterator make_space_at(const_iterator pos, size_type count)
+	// logic for resize_for_overwrite()
+	void resize_default(size_type /* old_size */, size_type /* count */, std::true_type /* trivial ctor */)
+	{
+		// leave garbage, as requested
+	}
+
+	void resize_default(size_type old_size, size_type count, std::false_type /* trivial ctor */)
+	{
+		this->ctor_values(old_size, count - old_size);
+	}
+
+	// leaves [idx, idx + count) uninitialised
+	iterator make_space_at(idx_offset idx, size_type count)
 	{
 		// change begin instead of end
 		// a bit of an optimisation, reduces the number of moves required
-		bool expand_forward = std::distance(this->cbegin(), pos) < std::distance(pos, this->cend());
+		auto old_size = this->size();
+		bool expand_forward = idx < old_size - idx;
 
-		auto buf_start_idx = this->idx_of(this->it_offset(pos));
-		this->ensure_alloc_copy_extra(this->size() + count);
+		this->ensure_alloc_copy_extra(old_size + count);
+		if(count == 0) {
+			return this->it_at(idx);
+		}
 
 		if(expand_forward) { // change front
-			auto old_begin = this->begin();
-			m_begin = this->it_offset(std::prev(this->end(), static_cast<difference_type>(count)));
-			for(auto from = old_begin, to = this->begin(); from != pos; ++from, ++to) {
-				atraits::construct(mm, to.get(), std::move(*from));
-				atraits::destroy(mm, from.get());
-			}
+			m_begin = static_cast<index_type>(this->abs_offset_of(abs_offset_rel(m_begin) - abs_offset_rel(count)));
+			this->shift_values_down(count, idx, is_trivial());
 		} else { // change back
-			auto old_end = this->rbegin();
-			auto end_pos = const_reverse_iterator(std::prev(pos));
+			m_end = static_cast<index_type>(this->abs_offset_of(m_end + count));
+			this->shift_values_up(idx, old_size - idx, count, is_trivial());
+		}
 
-			m_end = this->it_offset(std::next(this->end(), static_cast<difference_type>(count)));
-			auto new_end = this->rbegin();
+		// start of uninitalised block
+		return this->it_at(idx);
+	}
 
-			for(auto from = old_end, to = new_end; from != end_pos; ++from, ++to) {
-				atraits::construct(mm, to.base().get(), std::move(*from));
-				atraits::destroy(mm, from.base().get());
-			}
+	// logic for make_space_at, after begin has been moved back
+	// [count, count + num) moves to [0, num)
+	void shift_values_down(size_type count, size_type num, std::true_type /* trivial */)
+	{
+		this->move_values_down(count, 0, num, std::true_type());
+	}
+
+	void shift_values_down(size_type count, size_type num, std::false_type /* trivial */)
+	{
+		// the front is uninitialised, so needs constructing
+		// the rest overlaps, and can be assigned
+		auto num_ctor = std::min(count, num);
+		this->ctor_values_moved(count, 0, num_ctor);
+		if(num > count) {
+			this->move_values_down(2 * count, count, num - count);
 		}
+		this->dtor_value(this->offset_of(std::max(count, num)), this->offset_of(count + num));
+	}
 
-		// start of uninitalised block
-		return this->it_of(buf_start_idx);
+	// logic for make_space_at, after end has been moved forward
+	// [idx, idx + num) moves to [idx + count, idx + count + num)
+	void shift_values_up(size_type idx, size_type num, size_type count, std::true_type /* trivial */)
+	{
+		this->move_values_up(idx, idx + count, num, std::true_type());
+	}
+
+	void shift_values_up(size_type idx, size_type num, size_type count, std::false_type /* trivial */)
+	{
+		// as above, but mirrored
+		auto num_ctor = std::min(count, num);
+		this->ctor_values_moved(idx + num - num_ctor, idx + count + num - num_ctor, num_ctor);
+		if(num > count) {
+			this->move_values_up(idx, idx + count, num - count);
+		}
+		this->dtor_value(this->offset_of(idx), this->offset_of(idx + std::min(count, num)));
 	}
 
 	// interface, based on type of iterator
@@ -422,20 +974,20 @@ private: // internal methods
 	template <typename InputIt>
 	iterator it_insert(const_iterator pos, InputIt first, InputIt last, std::false_type /* is_fwd_it */)
 	{
-		// safely de-const the pointer
-		// cit => abs_offset => idx_offset => it
-		iterator insert_pos = std::next(this->begin(), this->idx_of(this->it_offset(pos)));
+		// count is unknown, so make space one at a time
+		auto start_idx = this->it_idx(pos);
 
-		for(auto it = first; it != last; ++it) {
-			insert_pos = this->it_insert(pos, it, last, 1);
+		for(auto idx = start_idx; first != last; ++first, ++idx) {
+			auto it = this->make_space_at(idx, 1);
+			this->ctor_value(this->it_offset(it), *first);
 		}
-		return insert_pos;
+		return this->it_at(start_idx);
 	}
 
 	template <typename InputIt>
 	iterator it_insert(const_iterator pos, InputIt first, InputIt last, size_type count)
 	{
-		auto begin_uninit_blk = this->make_space_at(pos, count);
+		auto begin_uninit_blk = this->make_space_at(this->it_idx(pos), count);
 
 		size_type num = 0;
 		for(auto it = begin_uninit_blk;
@@ -468,18 +1020,18 @@ public: // methods
 	// with alloc
 	explicit ring_buffer(const allocator_type& alloc)
 		noexcept
-		: mm(alloc)
-		, mb_size(0), memblk(nullptr)
+		: memblk(alloc, nullptr), mb_size(0)
 		, m_begin(0), m_end(0)
 	{
 	}
 
 	// blank, but with size
 	explicit ring_buffer(size_type cap, const allocator_type& alloc = allocator_type())
-		: mm(alloc)
-		, mb_size(cap + 1), memblk(this->alloc_memblk(mb_size))
+		: memblk(alloc, nullptr), mb_size(0)
 		, m_begin(0), m_end(0)
 	{
+		memblk.ptr = this->alloc_memblk(cap + 1);
+		mb_size = static_cast<index_type>(cap + 1);
 	}
 
 	// certain number of elements
@@ -509,11 +1061,10 @@ public: // methods
 
 	// copy
 	ring_buffer(const ring_buffer& other, const allocator_type& alloc)
-		: mm(alloc)
-		  // uses new mm to create memblk
-		, mb_size(other.size() + 1), memblk(this->alloc_memblk(mb_size))
-		, m_begin(0), m_end(other.size())
+		: ring_buffer(other.size(), alloc) // uses new mm to create memblk
 	{
+		m_end = static_cast<index_type>(other.size());
+
 		// a zip iterator would be nice
 		for(auto from = other.begin(), to = this->cbegin();
 		    from != other.end() && to != this->cend();
@@ -525,25 +1076,36 @@ public: // methods
 	// copy
 	ring_buffer(const ring_buffer& other)
 		: ring_buffer(other,
-			      atraits::select_on_container_copy_construction(other.mm))
+			      atraits::select_on_container_copy_construction(other.mm()))
 	{
 	}
 
 	// move
 	ring_buffer(ring_buffer&& other)
 		noexcept(std::is_nothrow_move_constructible<allocator_type>::value)
-		: mm(std::move(other.mm))
-		, mb_size(other.mb_size), memblk(other.memblk.release(), this->make_mb_dtor())
+		: memblk(std::move(other.mm()), other.memblk.ptr), mb_size(other.mb_size)
 		, m_begin(other.m_begin), m_end(other.m_end)
 	{
+		other.memblk.ptr = nullptr;
+		other.mb_size = other.m_begin = other.m_end = 0;
 	}
 
 	// move
 	ring_buffer(ring_buffer&& other, const allocator_type& alloc)
-		: mm(alloc)
-		, mb_size(other.mb_size), memblk(other.memblk.release(), this->make_mb_dtor())
-		, m_begin(other.m_begin), m_end(other.m_end)
+		: ring_buffer(alloc)
+	{
+		if(this->mm() == other.mm()) {
+			// can take ownership
+			this->swap(other);
+		} else {
+			this->assign(std::make_move_iterator(other.begin()),
+				     std::make_move_iterator(other.end()));
+		}
+	}
+
+	~ring_buffer()
 	{
+		this->free_memblk();
 	}
 
 	// }}}
@@ -553,7 +1115,12 @@ public: // methods
 	// copy and swap assignment
 	ring_buffer& operator=(const ring_buffer& other)
 	{
-		this->clear();
+		if(pocca::value && !(this->mm() == other.mm())) {
+			// memblk must be freed by the allocator which made it
+			this->release();
+		} else {
+			this->clear();
+		}
 		this->copy_assign_mm(other, pocca());
 		this->assign(other.begin(), other.end());
 		return *this;
@@ -564,7 +1131,9 @@ public: // methods
 		noexcept(pocma::value
 			&& std::is_nothrow_move_assignable<allocator_type>::value)
 	{
+		auto old_size = this->size();
 		this->move_assign(std::move(other), pocma());
+		this->size_changed(old_size);
 		return *this;
 	}
 
@@ -579,10 +1148,25 @@ public: // methods
 	// invalidates: all
 	void assign(size_type count, const T& val)
 	{
-		this->ensure_alloc_blanked(count);
+		auto old_size = this->size();
+		if(count > this->capacity()) {
+			// fill before freeing, since val may be in this ring
+			ring_buffer new_blk(count, this->mm());
+			new_blk.ctor_values_fill(0, count, val, is_trivial());
+			new_blk.m_end = static_cast<index_type>(count);
+
+			this->swap(new_blk);
+			return;
+		}
 
-		for(auto i = m_begin; i != m_end; ++i) {
-			this->ctor_value(i, val);
+		// assign over existing values, then construct or destroy the rest
+		this->fill_values(0, std::min(count, old_size), val);
+		if(count > old_size) {
+			this->ctor_values_fill(old_size, count - old_size, val, is_trivial());
+			m_end = static_cast<index_type>(this->offset_of(count));
+			this->size_changed(old_size);
+		} else {
+			this->pop_back_n(old_size - count);
 		}
 	}
 
@@ -590,8 +1174,10 @@ public: // methods
 	template <typename InputIt, int_if_input_it<InputIt> = 0>
 	void assign(InputIt first, InputIt last)
 	{
+		auto old_size = this->size();
 		this->dtor_value_all();
 		this->it_insert(this->cbegin(), first, last);
+		this->size_changed(old_size);
 	}
 
 	// invalidates: all
@@ -604,7 +1190,20 @@ public: // methods
 	allocator_type get_allocator() const
 		noexcept
 	{
-		return mm;
+		return this->mm();
+	}
+
+	// thresholds and callbacks, if Watermark has any
+	watermark_type& watermark()
+		noexcept
+	{
+		return memblk;
+	}
+
+	const watermark_type& watermark() const
+		noexcept
+	{
+		return memblk;
 	}
 
 	// }}}
@@ -659,6 +1258,32 @@ public: // methods
 		return *this->crbegin();
 	}
 
+	// the values as at most two contiguous runs, {pointer, count}
+	// second_segment() is empty unless the values wrap around the memblk
+	std::pair<pointer, size_type> first_segment()
+	{
+		auto seg = this->segment_bounds(0);
+		return { this->ptr_of(seg.first), seg.second };
+	}
+
+	std::pair<const_pointer, size_type> first_segment() const
+	{
+		auto seg = this->segment_bounds(0);
+		return { this->ptr_of(seg.first), seg.second };
+	}
+
+	std::pair<pointer, size_type> second_segment()
+	{
+		auto seg = this->segment_bounds(1);
+		return { this->ptr_of(seg.first), seg.second };
+	}
+
+	std::pair<const_pointer, size_type> second_segment() const
+	{
+		auto seg = this->segment_bounds(1);
+		return { this->ptr_of(seg.first), seg.second };
+	}
+
 	// }}}
 
 	// {{{ iterators
@@ -697,7 +1322,7 @@ public: // methods
 
 	reverse_iterator rbegin()
 	{
-		return reverse_iterator(this->it_of(m_end - 1));
+		return reverse_iterator(this->end());
 	}
 
 	const_reverse_iterator rbegin() const
@@ -707,12 +1332,12 @@ public: // methods
 
 	const_reverse_iterator crbegin() const
 	{
-		return const_reverse_iterator(this->cit_of(m_end - 1));
+		return const_reverse_iterator(this->cend());
 	}
 
 	reverse_iterator rend()
 	{
-		return reverse_iterator(this->it_of(m_begin - 1));
+		return reverse_iterator(this->begin());
 	}
 
 	const_reverse_iterator rend() const
@@ -722,7 +1347,7 @@ public: // methods
 
 	const_reverse_iterator crend() const
 	{
-		return const_reverse_iterator(this->cit_of(m_begin - 1));
+		return const_reverse_iterator(this->cbegin());
 	}
 
 	// // from a certain index
@@ -767,13 +1392,18 @@ public: // methods
 
 	size_type size() const
 	{
-		auto diff = m_end - m_begin;
-		return diff >= 0 ? diff : mb_size - diff;
+		if(mb_size == 0) {
+			return 0;
+		}
+		return (size_type(m_end) + mb_size - m_begin) % mb_size;
 	}
 
 	size_type max_size() const
 	{
-		return atraits::max_size(mm);
+		// the extra blank value must also be allocated, and mb_size must
+		// fit in index_type
+		return std::min<size_type>(atraits::max_size(this->mm()) - 1,
+		                           static_cast<size_type>(std::numeric_limits<index_type>::max() - 1));
 	}
 
 	// invalidates: all (if capacity changes)
@@ -788,7 +1418,7 @@ public: // methods
 
 	size_type capacity() const
 	{
-		return mb_size - 1;
+		return mb_size == 0 ? 0 : mb_size - 1;
 	}
 
 	// invalidates: all (if capacity changes)
@@ -797,13 +1427,9 @@ public: // methods
 		size_type size = this->size();
 		if(size == 0) {
 			// reset all
-			memblk.reset();
-			mb_size = m_begin = m_end = 0;
+			this->free_memblk();
 		} else if(size < this->capacity()) {
-			// logic is in copy ctor, but we can use the same allocator
-			// reduce code duplication
-			auto copy = ring_buffer(*this, mm);
-			this->swap(copy);
+			this->realloc_copy(size);
 		}
 	}
 
@@ -811,12 +1437,22 @@ public: // methods
 
 	// {{{ modifiers
 
-	// invalidates: all
+	// keeps capacity, so refilling doesn't reallocate
+	// invalidates: all values
 	void clear()
 	{
-		// reset all
-		memblk.reset();
-		m_begin = m_end = mb_size = 0;
+		auto old_size = this->size();
+		this->dtor_value_all();
+		this->size_changed(old_size);
+	}
+
+	// clear and free the memblk
+	// invalidates: all
+	void release()
+	{
+		auto old_size = this->size();
+		this->free_memblk();
+		this->size_changed(old_size);
 	}
 
 	// invalidates: all (if capacity changes)
@@ -824,9 +1460,7 @@ public: // methods
 	//              pos + after pos (if pos closer to end)
 	iterator insert(const_iterator pos, const value_type& value)
 	{
-		// hacky pointer arith
-		// valid since end iterator must not be dereferenced
-		return this->it_insert(pos, std::addressof(value), std::addressof(value) + 1);
+		return this->insert(pos, 1, value);
 	}
 
 	// invalidates: all (if capacity changes)
@@ -834,20 +1468,35 @@ public: // methods
 	//              pos + after pos (if pos closer to end)
 	iterator insert(const_iterator pos, value_type&& value)
 	{
-		return this->it_insert(pos,
+		auto old_size = this->size();
+		auto it = this->it_insert(pos,
 			// since decltype(&value) == value* (losing rvalue-ness)
 			std::make_move_iterator(std::addressof(value)),
 			std::make_move_iterator(std::addressof(value) + 1));
+		this->size_changed(old_size);
+		return it;
 	}
 
+	// invalidates: all (if capacity changes)
+	//              before pos (if pos closer to front)
+	//              pos + after pos (if pos closer to end)
 	iterator insert(const_iterator pos, size_type count, const value_type& value)
 	{
-		// TODO(timmy): find a way to get multiple inserts from one value
-		// use ring_buffer memory management to create dynamic array of references
-		using rbuf_type = ring_buffer<cref_wrapper, typename atraits::rebind_alloc<cref_wrapper>>;
-		rbuf_type rbuf(count, cref_wrapper{std::addressof(value)}, )
+		auto idx = this->it_idx(pos);
+		auto value_idx = this->idx_of_value(value);
+		auto old_size = this->size();
+
+		auto it = this->make_space_at(idx, count);
 
-		static_assert(false, "not implemented");
+		// value may be in this ring, and moved by make_space_at
+		if(value_idx < old_size) {
+			auto new_idx = value_idx < idx ? value_idx : value_idx + count;
+			this->ctor_values_fill(idx, count, memblk[this->offset_of(new_idx)], is_trivial());
+		} else {
+			this->ctor_values_fill(idx, count, value, is_trivial());
+		}
+		this->size_changed(old_size);
+		return it;
 	}
 
 	// invalidates: all (if capacity changes or side closer to pos != side closer to ret)
@@ -856,7 +1505,10 @@ public: // methods
 	template <typename InputIt, int_if_input_it<InputIt> = 0> // diambiguate
 	iterator insert(const_iterator pos, InputIt first, InputIt last)
 	{
-		return this->it_insert(pos, first, last);
+		auto old_size = this->size();
+		auto it = this->it_insert(pos, first, last);
+		this->size_changed(old_size);
+		return it;
 	}
 
 	// invalidates: all (if capacity changes or side closer to pos != side closer to next(ret))
@@ -864,7 +1516,51 @@ public: // methods
 	//              pos + after pos (if pos closer to end)
 	iterator insert(const_iterator pos, std::initializer_list<value_type> il)
 	{
-		return this->it_insert(pos, il.begin(), il.end(), il.size());
+		auto old_size = this->size();
+		auto it = this->it_insert(pos, il.begin(), il.end(), il.size());
+		this->size_changed(old_size);
+		return it;
+	}
+
+	// invalidates: pos + before pos (if pos closer to front)
+	//              pos + after pos (if pos closer to end)
+	iterator erase(const_iterator pos)
+	{
+		// ensure: pos != this->end()
+		return this->erase(pos, std::next(pos));
+	}
+
+	// invalidates: first to last + before first (if first closer to front)
+	//              first to last + after last (if last closer to end)
+	//              all (if the shrink policy shrinks)
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		auto first_idx = this->it_idx(first);
+		auto last_idx = this->it_idx(last);
+		auto count = last_idx - first_idx;
+		if(count == 0) {
+			return this->it_at(first_idx);
+		}
+		auto old_size = this->size();
+
+		// like make_space_at, move whichever side has fewer values
+		if(first_idx < this->size() - last_idx) { // change front
+			this->move_values_up(0, count, first_idx);
+
+			auto new_begin = this->offset_of(count);
+			this->dtor_value(m_begin, new_begin);
+			m_begin = static_cast<index_type>(new_begin);
+		} else { // change back
+			this->move_values_down(last_idx, first_idx, this->size() - last_idx);
+
+			auto new_end = this->offset_of(this->size() - count);
+			this->dtor_value(new_end, m_end);
+			m_end = static_cast<index_type>(new_end);
+		}
+
+		this->auto_shrink();
+		this->size_changed(old_size);
+		return this->it_at(first_idx);
 	}
 
 	// invalidates: all (if capacity changes)
@@ -878,7 +1574,7 @@ public: // methods
 	//              begin (otherwise)
 	reference push_front(value_type&& value)
 	{
-		return this->emplace_front(value);
+		return this->emplace_front(std::move(value));
 	}
 
 	// invalidates: all (if capacity changes)
@@ -886,22 +1582,33 @@ public: // methods
 	template <typename... Args>
 	reference emplace_front(Args&&... args)
 	{
-		this->ensure_alloc_copy_extra(this->size() + 1);
-
-		auto new_begin = this->it_offset(std::prev(this->begin()));
-		this->ctor_value(new_begin, std::forward<Args>(args)...);
-		m_begin = new_begin;
+		auto old_size = this->size();
+		if(old_size + 1 > this->capacity()) {
+			this->realloc_emplace(0, std::forward<Args>(args)...);
+		} else {
+			auto new_begin = this->it_offset(std::prev(this->begin()));
+			this->ctor_value(new_begin, std::forward<Args>(args)...);
+			m_begin = static_cast<index_type>(new_begin);
+		}
 
+		// after, since shrinking moves the values args may refer to
+		this->auto_shrink();
+		this->size_changed(old_size);
 		return this->front();
 	}
 
-	// invalidates: begin
+	// invalidates: all (if the shrink policy shrinks)
+	//              begin (otherwise)
 	void pop_front()
 	{
 		// ensure: this->size() > 0
+		auto old_size = this->size();
 		auto new_begin = this->it_offset(std::next(this->begin()));
 		this->dtor_value(m_begin);
-		m_begin = new_begin;
+		m_begin = static_cast<index_type>(new_begin);
+
+		this->auto_shrink();
+		this->size_changed(old_size);
 	}
 
 	// invalidates: all (if capacity changes)
@@ -915,7 +1622,7 @@ public: // methods
 	//              end (otherwise)
 	reference push_back(value_type&& value)
 	{
-		return this->emplace_back(value);
+		return this->emplace_back(std::move(value));
 	}
 
 	// invalidates: all (if capacity changes)
@@ -923,49 +1630,127 @@ public: // methods
 	template <typename... Args>
 	reference emplace_back(Args&&... args)
 	{
-		this->ensure_alloc_copy_extra(this->size() + 1);
-		this->ctor_value(m_end, std::forward<Args>(args)...);
-		m_end = this->it_offset(std::next(this->begin())); // increment
+		auto old_size = this->size();
+		if(old_size + 1 > this->capacity()) {
+			this->realloc_emplace(old_size, std::forward<Args>(args)...);
+		} else {
+			this->ctor_value(m_end, std::forward<Args>(args)...);
+			m_end = static_cast<index_type>(this->it_offset(std::next(this->end()))); // increment
+		}
 
+		// after, since shrinking moves the values args may refer to
+		this->auto_shrink();
+		this->size_changed(old_size);
 		return this->back(); // new back
 	}
 
-	// invalidates: end + one before end
+	// invalidates: all (if the shrink policy shrinks)
+	//              end + one before end (otherwise)
 	void pop_back()
 	{
 		// ensure: this->size() > 0
+		auto old_size = this->size();
 		auto new_end = this->it_offset(std::prev(this->end()));
 		this->dtor_value(new_end);
-		m_end = new_end;
+		m_end = static_cast<index_type>(new_end);
+
+		this->auto_shrink();
+		this->size_changed(old_size);
+	}
+
+	// invalidates: all (if the shrink policy shrinks)
+	//              begin to begin + count (otherwise)
+	void pop_front_n(size_type count)
+	{
+		// ensure: this->size() >= count
+		if(count == 0) {
+			return;
+		}
+
+		auto old_size = this->size();
+		auto new_begin = this->offset_of(count);
+		this->dtor_value(m_begin, new_begin);
+		m_begin = static_cast<index_type>(new_begin);
+
+		this->auto_shrink();
+		this->size_changed(old_size);
 	}
 
-	// default init
+	// invalidates: all (if the shrink policy shrinks)
+	//              end - count to end (otherwise)
+	void pop_back_n(size_type count)
+	{
+		// ensure: this->size() >= count
+		if(count == 0) {
+			return;
+		}
+
+		auto old_size = this->size();
+		auto new_end = this->offset_of(old_size - count);
+		this->dtor_value(new_end, m_end);
+		m_end = static_cast<index_type>(new_end);
+
+		this->auto_shrink();
+		this->size_changed(old_size);
+	}
+
+	// value init
 	// invalidates: all (if capacity changes)
 	void resize(size_type count)
 	{
-		this->resize_val(count);
+		if(count > this->size()) {
+			auto old_size = this->resize_uninit(count);
+			this->ctor_values(old_size, count - old_size);
+			m_end = static_cast<index_type>(this->offset_of(count));
+			this->size_changed(old_size);
+		} else {
+			this->pop_back_n(this->size() - count);
+		}
 	}
 
-	// value init
+	// copy init
 	// invalidates: all (if capacity changes)
 	void resize(size_type count, const value_type& value)
 	{
-		this->resize_val(count, value);
+		if(count > this->size()) {
+			auto value_idx = this->idx_of_value(value);
+			auto old_size = this->resize_uninit(count);
+
+			// value may be in this ring, and moved by resize_uninit
+			// values keep their index, so it can be found again
+			const value_type& src = value_idx < old_size ? memblk[this->offset_of(value_idx)] : value;
+			this->ctor_values_fill(old_size, count - old_size, src, is_trivial());
+			m_end = static_cast<index_type>(this->offset_of(count));
+			this->size_changed(old_size);
+		} else {
+			this->pop_back_n(this->size() - count);
+		}
 	}
 
+	// default init, so trivial values are left uninitialised
+	// invalidates: all (if capacity changes)
+	void resize_for_overwrite(size_type count)
+	{
+		if(count > this->size()) {
+			auto old_size = this->resize_uninit(count);
+			this->resize_default(old_size, count, is_trivial_ctor());
+			m_end = static_cast<index_type>(this->offset_of(count));
+			this->size_changed(old_size);
+		} else {
+			this->pop_back_n(this->size() - count);
+		}
+	}
+
+	// watermarks stay with their rings, and are told of the new sizes
 	void swap(ring_buffer& other)
 	{
-		// for adl
-		using std::swap;
+		auto old_size = this->size();
+		auto other_old_size = other.size();
 
-		this->swap_mm(other, pocs());
-		swap(memblk, other.memblk);
-		swap(mb_size, other.mb_size);
+		this->swap_values(other);
 
-		// deleter is bound to ring_buffer; undo swap
-		swap(memblk.get_deleter(), other.memblk.get_deleter());
-		swap(m_begin, other.m_begin);
-		swap(m_end, other.m_end);
+		this->size_changed(old_size);
+		other.size_changed(other_old_size);
 	}
 
 	// }}}
@@ -975,13 +1760,20 @@ public: // methods
 		lhs.swap(rhs);
 	}
 
+	// remove all values matching pred, in one pass
+	// returns the number of values removed
+	// invalidates: all after the first removed value
+	//              all (if the shrink policy shrinks)
+	template <typename Pred>
+	friend size_type erase_if(ring_buffer& rb, Pred pred)
+	{
+		auto old_size = rb.size();
+		auto removed = rb.erase_values_if(pred);
+		rb.auto_shrink();
+		rb.size_changed(old_size);
+		return removed;
+	}
+
 	// TODO(timmy): add member functions
 
 };
-
-template <typename T, typename Allocator>
-void ring_buffer<T, Allocator>::destruct_memblk(ring_buffer* self, pointer ptr)
-{
-	self->dtor_value_all();
-	atraits::deallocate(self->mm, ptr, self->mb_size);
-}
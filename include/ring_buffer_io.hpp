@@ -0,0 +1,518 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Binary snapshot and restore of ring_buffer contents.
+ *
+ * The format is a 16 byte header (magic, sizeof(T), value count) followed by
+ * the values in order. Trivially copyable values are written as raw bytes,
+ * straight from the ring's (at most two) segments, and read straight into a
+ * fresh memblk, so there is no per-value work. The format uses the native
+ * byte order and layout, so is only meant to be read back on the same
+ * platform.
+ *
+ * Other types are written one value at a time by specialising
+ * ring_buffer_value_io<T>, e.g.
+ *
+ * \code
+ *
+ * template <>
+ * struct ring_buffer_value_io<std::string>
+ * {
+ *      static void save(std::ostream& os, const std::string& val);
+ *      static std::string load(std::istream& is);
+ * };
+ *
+ * \endcode
+ *
+ * The file descriptor overloads use writev/read, so are POSIX only, and are
+ * only provided for trivially copyable values.
+ *
+ * For byte rings, read_from and write_to move data between a file
+ * descriptor (e.g. a socket) and the ring with a single readv/writev over
+ * the ring's free or used segments, without a temporary buffer.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * template <typename T, ...>
+ * bool save(const ring_buffer<T, ...>& rb, std::ostream& os);
+ * template <typename T, ...>
+ * bool load(ring_buffer<T, ...>& rb, std::istream& is);
+ *
+ * // POSIX
+ * template <typename T, ...>
+ * bool save(const ring_buffer<T, ...>& rb, int fd);
+ * template <typename T, ...>
+ * bool load(ring_buffer<T, ...>& rb, int fd);
+ *
+ * // POSIX, byte rings
+ * template <typename T, ...>
+ * ssize_t read_from(ring_buffer<T, ...>& rb, int fd, std::size_t max);
+ * template <typename T, ...>
+ * ssize_t write_to(ring_buffer<T, ...>& rb, int fd, std::size_t max);
+ *
+ * // POSIX, for ring_buffer_watermark
+ * struct ring_buffer_eventfd_notify { int fd; void operator()() const; };
+ *
+ * \endcode
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define RING_BUFFER_IO_POSIX 1
+#endif
+
+#include "ring_buffer.hpp"
+
+// hook for values which are not trivially copyable, see above
+template <typename T>
+struct ring_buffer_value_io;
+
+namespace ring_buffer_io_detail {
+
+// {{{ header
+
+struct header
+{
+	char magic[4];
+	std::uint32_t value_size;
+	std::uint64_t count;
+};
+
+static_assert(sizeof(header) == 16, "header should have no padding");
+
+static const char magic[4] = { 'R', 'I', 'N', 'G' };
+
+template <typename T>
+header make_header(std::uint64_t count)
+{
+	header hdr;
+	std::memcpy(hdr.magic, magic, sizeof(magic));
+	hdr.value_size = static_cast<std::uint32_t>(sizeof(T));
+	hdr.count = count;
+	return hdr;
+}
+
+// most bytes of values read before checking they're there, so a corrupt
+// count fails when the data runs out instead of allocating it all up front
+static const std::size_t load_chunk_bytes = std::size_t(1) << 20;
+
+template <typename T, typename Size>
+Size load_chunk_values()
+{
+	return static_cast<Size>(std::max<std::size_t>(load_chunk_bytes / sizeof(T), 1));
+}
+
+// false if the header isn't for values of type T
+template <typename T, typename RB>
+bool check_header(const header& hdr, const RB& rb)
+{
+	return std::memcmp(hdr.magic, magic, sizeof(magic)) == 0
+		&& hdr.value_size == sizeof(T)
+		&& hdr.count <= rb.max_size();
+}
+
+// }}}
+
+// {{{ streams
+
+template <typename RB>
+void save_values(const RB& rb, std::ostream& os, std::true_type /* trivial */)
+{
+	using T = typename RB::value_type;
+
+	auto one = rb.first_segment();
+	auto two = rb.second_segment();
+	os.write(reinterpret_cast<const char*>(one.first), static_cast<std::streamsize>(one.second * sizeof(T)));
+	if(two.second > 0) {
+		os.write(reinterpret_cast<const char*>(two.first), static_cast<std::streamsize>(two.second * sizeof(T)));
+	}
+}
+
+template <typename RB>
+void save_values(const RB& rb, std::ostream& os, std::false_type /* trivial */)
+{
+	using T = typename RB::value_type;
+
+	for(const auto& val : rb) {
+		ring_buffer_value_io<T>::save(os, val);
+	}
+}
+
+// read count trivially copyable values into the empty rb, chunk values at a
+// time, with read(void* buf, std::size_t bytes)
+// rb has no memblk to start with and only grows by reserve, so the values
+// are one segment from the start
+template <typename RB, typename Read>
+bool load_trivial(RB& rb, typename RB::size_type count, typename RB::size_type chunk, Read read)
+{
+	using T = typename RB::value_type;
+
+	while(rb.size() < count) {
+		auto old_size = rb.size();
+		auto n = std::min(count - old_size, chunk);
+		if(old_size + n > rb.capacity()) {
+			// double, but not past count
+			rb.reserve(std::min(count, std::max(old_size + n, 2 * rb.capacity())));
+		}
+		rb.resize_for_overwrite(old_size + n);
+
+		if(!read(rb.first_segment().first + old_size, n * sizeof(T))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template <typename RB>
+bool load_values(RB& rb, std::istream& is, typename RB::size_type count, std::true_type /* trivial */)
+{
+	using T = typename RB::value_type;
+
+	auto chunk = load_chunk_values<T, typename RB::size_type>();
+	return load_trivial(rb, count, chunk, [&](void* buf, std::size_t bytes) {
+		is.read(static_cast<char*>(buf), static_cast<std::streamsize>(bytes));
+		return static_cast<bool>(is);
+	});
+}
+
+template <typename RB>
+bool load_values(RB& rb, std::istream& is, typename RB::size_type count, std::false_type /* trivial */)
+{
+	using T = typename RB::value_type;
+
+	// the rest grow as values arrive
+	rb.reserve(std::min(count, load_chunk_values<T, typename RB::size_type>()));
+	for(typename RB::size_type i = 0; i < count; ++i) {
+		auto val = ring_buffer_value_io<T>::load(is);
+		if(!is) {
+			return false;
+		}
+		rb.push_back(std::move(val));
+	}
+	return true;
+}
+
+// }}}
+
+#ifdef RING_BUFFER_IO_POSIX
+
+// {{{ file descriptors
+
+// write all of iov, resuming after partial writes
+inline bool writev_all(int fd, struct iovec* iov, int iovcnt)
+{
+	while(iovcnt > 0) {
+		auto written = ::writev(fd, iov, iovcnt);
+		if(written < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+
+		auto left = static_cast<std::size_t>(written);
+		while(iovcnt > 0 && left >= iov->iov_len) {
+			left -= iov->iov_len;
+			++iov;
+			--iovcnt;
+		}
+		if(iovcnt > 0) {
+			iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+			iov->iov_len -= left;
+		}
+	}
+	return true;
+}
+
+// private access to rings
+struct ring_access
+{
+	// the first (0) or second (1) run of free space after the back of rb
+	template <typename RB>
+	static std::pair<typename RB::pointer, typename RB::size_type> free_segment(RB& rb, int which)
+	{
+		auto seg = rb.free_bounds(which);
+		return { rb.ptr_of(seg.first), seg.second };
+	}
+
+	// add count values, constructed in the free space, to the back of rb
+	template <typename RB>
+	static void commit_back(RB& rb, typename RB::size_type count)
+	{
+		rb.commit_back(count);
+	}
+};
+
+// fill iov with the runs of free space of rb, up to count values
+// returns the number of entries used
+template <typename RB>
+int free_iov_of(RB& rb, typename RB::size_type count, struct iovec* iov)
+{
+	using T = typename RB::value_type;
+
+	int iovcnt = 0;
+	for(int which = 0; which < 2 && count > 0; ++which) {
+		auto seg = ring_access::free_segment(rb, which);
+		auto len = std::min(count, seg.second);
+		if(len > 0) {
+			iov[iovcnt].iov_base = static_cast<void*>(seg.first);
+			iov[iovcnt].iov_len = len * sizeof(T);
+			++iovcnt;
+			count -= len;
+		}
+	}
+	return iovcnt;
+}
+
+// fill iov with the (at most two) runs of values [idx, idx + count) of rb
+// returns the number of entries used
+template <typename RB>
+int iov_of(RB& rb, typename RB::size_type idx, typename RB::size_type count, struct iovec* iov)
+{
+	using T = typename RB::value_type;
+
+	auto one = rb.first_segment();
+	auto two = rb.second_segment();
+	int iovcnt = 0;
+
+	if(idx < one.second && count > 0) {
+		auto len = std::min(count, one.second - idx);
+		iov[iovcnt].iov_base = static_cast<void*>(one.first + idx);
+		iov[iovcnt].iov_len = len * sizeof(T);
+		++iovcnt;
+
+		idx += len;
+		count -= len;
+	}
+	if(count > 0) {
+		iov[iovcnt].iov_base = static_cast<void*>(two.first + (idx - one.second));
+		iov[iovcnt].iov_len = count * sizeof(T);
+		++iovcnt;
+	}
+	return iovcnt;
+}
+
+inline bool read_all(int fd, void* buf, std::size_t len)
+{
+	auto out = static_cast<char*>(buf);
+	while(len > 0) {
+		auto got = ::read(fd, out, len);
+		if(got < 0 && errno == EINTR) {
+			continue;
+		}
+		if(got <= 0) {
+			return false;
+		}
+		out += got;
+		len -= static_cast<std::size_t>(got);
+	}
+	return true;
+}
+
+// }}}
+
+#endif
+
+} // namespace ring_buffer_io_detail
+
+// write a snapshot of rb to os
+// returns false if writing failed
+template <typename T, typename Allocator, typename Index, typename ShrinkPolicy, typename Watermark>
+bool save(const ring_buffer<T, Allocator, Index, ShrinkPolicy, Watermark>& rb, std::ostream& os)
+{
+	namespace detail = ring_buffer_io_detail;
+
+	auto hdr = detail::make_header<T>(rb.size());
+	os.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+	detail::save_values(rb, os, std::integral_constant<bool, std::is_trivially_copyable<T>::value>());
+	return static_cast<bool>(os);
+}
+
+// replace the contents of rb with a snapshot read from is
+// returns false if the snapshot is malformed or cut short, leaving rb empty
+// invalidates: all
+template <typename T, typename Allocator, typename Index, typename ShrinkPolicy, typename Watermark>
+bool load(ring_buffer<T, Allocator, Index, ShrinkPolicy, Watermark>& rb, std::istream& is)
+{
+	namespace detail = ring_buffer_io_detail;
+	using size_type = typename ring_buffer<T, Allocator, Index, ShrinkPolicy, Watermark>::size_type;
+
+	rb.release();
+
+	detail::header hdr;
+	if(!is.read(reinterpret_cast<char*>(&hdr), sizeof(hdr)) || !detail::check_header<T>(hdr, rb)) {
+		return false;
+	}
+
+	if(!detail::load_values(rb, is, static_cast<size_type>(hdr.count),
+	                        std::integral_constant<bool, std::is_trivially_copyable<T>::value>())) {
+		rb.release();
+		return false;
+	}
+	return true;
+}
+
+#ifdef RING_BUFFER_IO_POSIX
+
+// write a snapshot of rb to fd, with a single writev (barring partial writes)
+// returns false if writing failed, with errno set
+template <typename T, typename Allocator, typename Index, typename ShrinkPolicy, typename Watermark>
+bool save(const ring_buffer<T, Allocator, Index, ShrinkPolicy, Watermark>& rb, int fd)
+{
+	static_assert(std::is_trivially_copyable<T>::value,
+	              "saving to a file descriptor needs trivially copyable values, use a stream instead");
+
+	auto hdr = ring_buffer_io_detail::make_header<T>(rb.size());
+	auto one = rb.first_segment();
+	auto two = rb.second_segment();
+
+	struct iovec iov[3];
+	iov[0].iov_base = &hdr;
+	iov[0].iov_len = sizeof(hdr);
+	iov[1].iov_base = const_cast<void*>(static_cast<const void*>(one.first));
+	iov[1].iov_len = one.second * sizeof(T);
+	iov[2].iov_base = const_cast<void*>(static_cast<const void*>(two.first));
+	iov[2].iov_len = two.second * sizeof(T);
+
+	return ring_buffer_io_detail::writev_all(fd, iov, two.second > 0 ? 3 : 2);
+}
+
+// replace the contents of rb with a snapshot read from fd
+// returns false if the snapshot is malformed or cut short, leaving rb empty
+// invalidates: all
+template <typename T, typename Allocator, typename Index, typename ShrinkPolicy, typename Watermark>
+bool load(ring_buffer<T, Allocator, Index, ShrinkPolicy, Watermark>& rb, int fd)
+{
+	static_assert(std::is_trivially_copyable<T>::value,
+	              "loading from a file descriptor needs trivially copyable values, use a stream instead");
+
+	namespace detail = ring_buffer_io_detail;
+	using size_type = typename ring_buffer<T, Allocator, Index, ShrinkPolicy, Watermark>::size_type;
+
+	rb.release();
+
+	detail::header hdr;
+	if(!detail::read_all(fd, &hdr, sizeof(hdr)) || !detail::check_header<T>(hdr, rb)) {
+		return false;
+	}
+	auto count = static_cast<size_type>(hdr.count);
+
+	// a regular file must hold all the values, and then they can be read in
+	// one go. anything else (e.g. a pipe) is read in chunks
+	auto chunk = detail::load_chunk_values<T, size_type>();
+	struct stat st;
+	if(::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+		auto pos = ::lseek(fd, 0, SEEK_CUR);
+		if(pos >= 0 && (st.st_size < pos
+		                || static_cast<std::uint64_t>(st.st_size - pos) / sizeof(T) < count)) {
+			return false;
+		}
+		chunk = std::max<size_type>(count, 1);
+	}
+
+	if(!detail::load_trivial(rb, count, chunk, [&](void* buf, std::size_t bytes) {
+		return detail::read_all(fd, buf, bytes);
+	})) {
+		rb.release();
+		return false;
+	}
+	return true;
+}
+
+// read at most max bytes from fd into the back of rb, with one readv
+// straight into the free space. the ring only grows (by at least max) if it
+// is full, so a return of 0 always means end of file
+// returns the bytes read, or -1 with errno set (rb is unchanged)
+// invalidates: all (if capacity changes)
+//              none (otherwise)
+template <typename T, typename Allocator, typename Index, typename ShrinkPolicy, typename Watermark>
+ssize_t read_from(ring_buffer<T, Allocator, Index, ShrinkPolicy, Watermark>& rb, int fd, std::size_t max)
+{
+	static_assert(sizeof(T) == 1 && std::is_trivially_copyable<T>::value,
+	              "read_from is only for byte rings");
+
+	// geometric, so a consumer which lags doesn't copy the ring every read
+	if(rb.size() == rb.capacity()) {
+		rb.reserve(std::max(rb.size() + max, rb.capacity() + rb.capacity() / 2));
+	}
+
+	// read into the free space, then add only what was read
+	struct iovec iov[2];
+	auto iovcnt = ring_buffer_io_detail::free_iov_of(rb, max, iov);
+
+	ssize_t got;
+	do {
+		got = ::readv(fd, iov, iovcnt);
+	} while(got < 0 && errno == EINTR);
+
+	if(got > 0) {
+		ring_buffer_io_detail::ring_access::commit_back(rb, static_cast<std::size_t>(got));
+	}
+	return got;
+}
+
+// write at most max bytes from the front of rb to fd, with one writev
+// straight from the used segments, and pop what was written. on a partial
+// write, the rest stays at the front of rb for the next call
+// returns the bytes written, or -1 with errno set (rb is unchanged)
+// invalidates: begin to begin + (return value)
+template <typename T, typename Allocator, typename Index, typename ShrinkPolicy, typename Watermark>
+ssize_t write_to(ring_buffer<T, Allocator, Index, ShrinkPolicy, Watermark>& rb, int fd, std::size_t max)
+{
+	static_assert(sizeof(T) == 1 && std::is_trivially_copyable<T>::value,
+	              "write_to is only for byte rings");
+
+	auto count = std::min<std::size_t>(max, rb.size());
+	if(count == 0) {
+		return 0;
+	}
+
+	struct iovec iov[2];
+	auto iovcnt = ring_buffer_io_detail::iov_of(rb, 0, count, iov);
+
+	ssize_t written;
+	do {
+		written = ::writev(fd, iov, iovcnt);
+	} while(written < 0 && errno == EINTR);
+
+	if(written > 0) {
+		rb.pop_front_n(static_cast<std::size_t>(written));
+	}
+	return written;
+}
+
+// ring_buffer_watermark callback, which notifies an eventfd (or pipe) by
+// writing a count of 1, e.g. to wake a producer blocked in poll()
+struct ring_buffer_eventfd_notify
+{
+	int fd;
+
+	void operator()() const
+	{
+		std::uint64_t one = 1;
+		while(::write(fd, &one, sizeof(one)) < 0 && errno == EINTR) {
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,432 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Bounded channel for C++20 coroutines, with ring_buffer storage.
+ *
+ * `co_await ch.push(x)' suspends while the channel is full, and
+ * `co_await ch.pop()' suspends while it is empty. A suspended coroutine's
+ * awaiter lives in its coroutine frame, so the waiter lists are intrusive
+ * and waiting allocates nothing.
+ *
+ * Woken coroutines are not resumed inline, but posted to a ring_executor,
+ * which resumes them in batches from run(). Everything is single threaded:
+ * a channel, its executor and all coroutines using them must stay on one
+ * thread, so no atomics or locks are needed.
+ *
+ * A value pushed while a coroutine is waiting to pop goes straight to the
+ * waiting coroutine, and a pop from a full channel takes one waiting pusher's
+ * value into the ring, so values stay in push order.
+ *
+ * note: only available when compiling as C++20 with coroutine support.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * class ring_executor
+ * {
+ * public:
+ *
+ *      void post(std::coroutine_handle<> h);
+ *      void spawn(ring_task task);
+ *      std::size_t run(); // until no coroutines are ready
+ *      bool empty() const;
+ * };
+ *
+ * template <typename T, typename Allocator = std::allocator<T>>
+ * class ring_channel
+ * {
+ * public:
+ *
+ *      ring_channel(ring_executor& ex, size_type capacity);
+ *
+ *      awaitable<bool> push(T value);          // false if closed
+ *      awaitable<std::optional<T>> pop();      // nullopt if closed and empty
+ *      bool try_push(T& value);
+ *      std::optional<T> try_pop();
+ *      void close();
+ *
+ *      size_type size() const;
+ *      size_type capacity() const;
+ *      bool closed() const;
+ * };
+ *
+ * \endcode
+ */
+
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "ring_buffer.hpp"
+
+class ring_executor;
+
+// fire and forget coroutine, started by ring_executor::spawn
+// the frame is freed when the coroutine finishes
+class ring_task
+{
+public: // statics
+
+	struct promise_type
+	{
+		ring_task get_return_object()
+		{
+			return ring_task(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+
+		// started by the executor, not inline
+		std::suspend_always initial_suspend() noexcept
+		{
+			return {};
+		}
+
+		std::suspend_never final_suspend() noexcept
+		{
+			return {};
+		}
+
+		void return_void()
+		{
+		}
+
+		void unhandled_exception()
+		{
+			std::terminate();
+		}
+	};
+
+private: // variables
+
+	std::coroutine_handle<promise_type> handle;
+
+	friend class ring_executor;
+
+public: // methods
+
+	explicit ring_task(std::coroutine_handle<promise_type> h)
+		: handle(h)
+	{
+	}
+
+	ring_task(ring_task&& other) noexcept
+		: handle(std::exchange(other.handle, nullptr))
+	{
+	}
+
+	ring_task(const ring_task&) = delete;
+	ring_task& operator=(const ring_task&) = delete;
+	ring_task& operator=(ring_task&&) = delete;
+
+	~ring_task()
+	{
+		// never started
+		if(handle) {
+			handle.destroy();
+		}
+	}
+};
+
+// single threaded executor, resuming ready coroutines in batches
+class ring_executor
+{
+private: // variables
+
+	ring_buffer<std::coroutine_handle<>> ready;
+	ring_buffer<std::coroutine_handle<>> batch;
+
+public: // methods
+
+	// resume h from the next run()
+	void post(std::coroutine_handle<> h)
+	{
+		ready.push_back(h);
+	}
+
+	// start the coroutine from the next run()
+	void spawn(ring_task task)
+	{
+		this->post(std::exchange(task.handle, nullptr));
+	}
+
+	// resume ready coroutines until there are none
+	// coroutines posted while a batch runs go in the next batch
+	// returns the number resumed
+	std::size_t run()
+	{
+		std::size_t count = 0;
+		while(!ready.empty()) {
+			// swapping keeps both memblks, so steady state doesn't allocate
+			ready.swap(batch);
+			for(auto h : batch) {
+				h.resume();
+			}
+			count += batch.size();
+			batch.clear();
+		}
+		return count;
+	}
+
+	bool empty() const
+	{
+		return ready.empty();
+	}
+};
+
+template <typename T, typename Allocator = std::allocator<T>>
+class ring_channel
+{
+public: // statics
+
+	using value_type = T;
+	using size_type  = typename ring_buffer<T, Allocator>::size_type;
+
+private: // internal statics
+
+	// {{{ waiters
+
+	// base of the awaiters, linked while suspended
+	struct waiter
+	{
+		waiter* next = nullptr;
+		std::coroutine_handle<> handle;
+	};
+
+	// fifo of waiters, linked through waiter::next
+	struct waiter_list
+	{
+		waiter* head = nullptr;
+		waiter* tail = nullptr;
+
+		bool empty() const
+		{
+			return head == nullptr;
+		}
+
+		void push(waiter* w)
+		{
+			w->next = nullptr;
+			if(tail == nullptr) {
+				head = w;
+			} else {
+				tail->next = w;
+			}
+			tail = w;
+		}
+
+		waiter* pop()
+		{
+			auto w = head;
+			head = w->next;
+			if(head == nullptr) {
+				tail = nullptr;
+			}
+			return w;
+		}
+	};
+
+	// }}}
+
+public: // statics
+
+	// {{{ awaiters
+
+	class push_awaiter : private waiter
+	{
+	private:
+
+		friend class ring_channel;
+
+		ring_channel* ch;
+		std::optional<T> value;
+		bool ok = true;
+
+	public:
+
+		push_awaiter(ring_channel* i_ch, T&& i_value)
+			: ch(i_ch), value(std::move(i_value))
+		{
+		}
+
+		bool await_ready()
+		{
+			if(ch->closed()) {
+				ok = false;
+				return true;
+			}
+			return ch->try_push(*value);
+		}
+
+		void await_suspend(std::coroutine_handle<> h)
+		{
+			this->handle = h;
+			ch->pushers.push(this);
+		}
+
+		// false if the channel was closed, and the value was not pushed
+		bool await_resume()
+		{
+			return ok;
+		}
+	};
+
+	class pop_awaiter : private waiter
+	{
+	private:
+
+		friend class ring_channel;
+
+		ring_channel* ch;
+		std::optional<T> value;
+
+	public:
+
+		explicit pop_awaiter(ring_channel* i_ch)
+			: ch(i_ch)
+		{
+		}
+
+		bool await_ready()
+		{
+			value = ch->try_pop();
+			return value.has_value() || ch->closed();
+		}
+
+		void await_suspend(std::coroutine_handle<> h)
+		{
+			this->handle = h;
+			ch->poppers.push(this);
+		}
+
+		// nullopt if the channel was closed, and is empty
+		std::optional<T> await_resume()
+		{
+			return std::move(value);
+		}
+	};
+
+	// }}}
+
+private: // variables
+
+	ring_executor* ex;
+	ring_buffer<T, Allocator> values;
+	size_type cap;
+	bool is_closed = false;
+
+	// invariant: pushers is only non-empty when values is full,
+	//            and poppers only when values is empty
+	waiter_list pushers;
+	waiter_list poppers;
+
+public: // methods
+
+	// a capacity of 0 makes an unbuffered channel, where push waits for pop
+	ring_channel(ring_executor& i_ex, size_type capacity, const Allocator& alloc = Allocator())
+		: ex(std::addressof(i_ex)), values(capacity, alloc), cap(capacity)
+	{
+	}
+
+	ring_channel(const ring_channel&) = delete;
+	ring_channel& operator=(const ring_channel&) = delete;
+
+	// suspends while full
+	push_awaiter push(T value)
+	{
+		return push_awaiter(this, std::move(value));
+	}
+
+	// suspends while empty
+	pop_awaiter pop()
+	{
+		return pop_awaiter(this);
+	}
+
+	// push without waiting, moving from value only if it was pushed
+	bool try_push(T& value)
+	{
+		if(is_closed) {
+			return false;
+		}
+
+		if(!poppers.empty()) {
+			// values is empty, so hand over directly
+			auto w = static_cast<pop_awaiter*>(poppers.pop());
+			w->value.emplace(std::move(value));
+			ex->post(w->handle);
+			return true;
+		}
+
+		if(values.size() == cap) {
+			return false;
+		}
+		values.push_back(std::move(value));
+		return true;
+	}
+
+	// pop without waiting
+	std::optional<T> try_pop()
+	{
+		std::optional<T> out;
+
+		if(!values.empty()) {
+			out.emplace(std::move(values.front()));
+			values.pop_front();
+
+			// space for one waiting pusher
+			if(!pushers.empty()) {
+				auto w = static_cast<push_awaiter*>(pushers.pop());
+				values.push_back(std::move(*w->value));
+				ex->post(w->handle);
+			}
+		} else if(!pushers.empty()) {
+			// unbuffered, take directly
+			auto w = static_cast<push_awaiter*>(pushers.pop());
+			out.emplace(std::move(*w->value));
+			ex->post(w->handle);
+		}
+
+		return out;
+	}
+
+	// wake all waiters: pushers fail, and poppers get nullopt
+	// values already pushed can still be popped
+	void close()
+	{
+		is_closed = true;
+		while(!pushers.empty()) {
+			auto w = static_cast<push_awaiter*>(pushers.pop());
+			w->ok = false;
+			ex->post(w->handle);
+		}
+		while(!poppers.empty()) {
+			ex->post(poppers.pop()->handle);
+		}
+	}
+
+	size_type size() const
+	{
+		return values.size();
+	}
+
+	size_type capacity() const
+	{
+		return cap;
+	}
+
+	bool closed() const
+	{
+		return is_closed;
+	}
+};
+
+#endif
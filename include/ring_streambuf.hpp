@@ -0,0 +1,293 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * std::streambuf over a ring_buffer<char>, so iostreams can read and write
+ * the ring in place.
+ *
+ * Reading consumes from the front of the ring and writing appends to the
+ * back. The get area is one contiguous segment of the ring, and the put
+ * area is the free space after the back, so the usual inline paths of
+ * istream/ostream touch the ring's memory directly. xsgetn and xsputn copy
+ * whole segments, with at most two memcpy each.
+ *
+ * Read values are only popped from the ring on pubsync(), or when a write
+ * needs the space. Until then, pubseekoff/pubseekpos can move the read
+ * position anywhere within the window of values still in the ring.
+ * Positions count from the first value ever read through this streambuf.
+ *
+ * note: while writing, the ring may hold unwritten space at the back. It is
+ *       only up to date after pubsync(), or when the streambuf is destroyed.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * class ring_streambuf : public std::streambuf
+ * {
+ * public:
+ *
+ *      explicit ring_streambuf(ring_buffer<char>& ring);
+ *      ~ring_streambuf(); // syncs
+ *
+ *      ring_buffer<char>& ring();
+ * };
+ *
+ * \endcode
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <ios>
+#include <memory>
+#include <streambuf>
+#include <utility>
+
+#include "ring_buffer.hpp"
+
+class ring_streambuf : public std::streambuf
+{
+public: // statics
+
+	using ring_type = ring_buffer<char>;
+	using size_type = ring_type::size_type;
+
+private: // internal statics
+
+	// smallest capacity to grow to when writing
+	static constexpr size_type min_capacity = 64;
+
+private: // variables
+
+	ring_type* m_ring;
+
+	// index in the ring of the start of the get area,
+	// or of the read position if there is no get area
+	size_type m_get_idx;
+
+	// stream position of the front of the ring
+	off_type m_popped;
+
+private: // internal methods
+
+	// {{{ internal methods
+
+	// the contiguous run of the ring starting at index idx, {pointer, count}
+	std::pair<char*, size_type> run_at(size_type idx)
+	{
+		auto one = m_ring->first_segment();
+		if(idx < one.second) {
+			return { one.first + idx, one.second - idx };
+		}
+		auto two = m_ring->second_segment();
+		return { two.first + (idx - one.second), two.second - (idx - one.second) };
+	}
+
+	size_type read_idx() const
+	{
+		return m_get_idx + static_cast<size_type>(this->gptr() - this->eback());
+	}
+
+	// forget the get area, keeping the read position
+	void drop_get()
+	{
+		m_get_idx = this->read_idx();
+		this->setg(nullptr, nullptr, nullptr);
+	}
+
+	// trim unwritten space from the back of the ring
+	void sync_put()
+	{
+		if(this->pbase() != nullptr) {
+			m_ring->pop_back_n(static_cast<size_type>(this->epptr() - this->pptr()));
+			this->setp(nullptr, nullptr);
+		}
+	}
+
+	// pop values which have been read
+	void discard_read()
+	{
+		this->drop_get();
+		m_ring->pop_front_n(m_get_idx);
+		m_popped += static_cast<off_type>(m_get_idx);
+		m_get_idx = 0;
+	}
+
+	// make space for count more values, reusing the space of read values first
+	// note: put area must be synced
+	void ensure_space(size_type count)
+	{
+		if(m_ring->size() + count <= m_ring->capacity()) {
+			return;
+		}
+
+		this->discard_read();
+		auto cap = m_ring->capacity();
+		auto want = m_ring->size() + count;
+		if(want > cap) {
+			// copied, since std::max takes a reference
+			size_type grown = min_capacity;
+			m_ring->reserve(std::max(want, std::max(grown, cap + cap / 2)));
+		}
+	}
+
+	// }}}
+
+protected: // streambuf overrides
+
+	// {{{ get
+
+	std::streamsize showmanyc() override
+	{
+		this->sync_put();
+		return static_cast<std::streamsize>(m_ring->size() - this->read_idx());
+	}
+
+	int_type underflow() override
+	{
+		this->drop_get();
+		this->sync_put();
+		if(m_get_idx >= m_ring->size()) {
+			return traits_type::eof();
+		}
+
+		auto run = this->run_at(m_get_idx);
+		this->setg(run.first, run.first, run.first + run.second);
+		return traits_type::to_int_type(*this->gptr());
+	}
+
+	std::streamsize xsgetn(char_type* s, std::streamsize n) override
+	{
+		this->drop_get();
+		this->sync_put();
+
+		auto want = static_cast<size_type>(n);
+		size_type got = 0;
+		while(got < want && m_get_idx < m_ring->size()) {
+			auto run = this->run_at(m_get_idx);
+			auto len = std::min(run.second, want - got);
+			std::memcpy(s + got, run.first, len);
+
+			got += len;
+			m_get_idx += len;
+		}
+		return static_cast<std::streamsize>(got);
+	}
+
+	// }}}
+
+	// {{{ put
+
+	int_type overflow(int_type ch) override
+	{
+		this->sync_put();
+		if(traits_type::eq_int_type(ch, traits_type::eof())) {
+			return traits_type::not_eof(ch);
+		}
+
+		this->ensure_space(1);
+
+		// claim the contiguous free space after the back
+		auto old_size = m_ring->size();
+		m_ring->resize_for_overwrite(m_ring->capacity());
+		auto run = this->run_at(old_size);
+		m_ring->pop_back_n(m_ring->size() - old_size - run.second);
+
+		this->setp(run.first, run.first + run.second);
+		*this->pptr() = traits_type::to_char_type(ch);
+		this->pbump(1);
+		return ch;
+	}
+
+	std::streamsize xsputn(const char_type* s, std::streamsize n) override
+	{
+		this->sync_put();
+
+		auto count = static_cast<size_type>(n);
+		this->ensure_space(count);
+
+		auto old_size = m_ring->size();
+		m_ring->resize_for_overwrite(old_size + count);
+
+		size_type put = 0;
+		while(put < count) {
+			auto run = this->run_at(old_size + put);
+			auto len = std::min(run.second, count - put);
+			std::memcpy(run.first, s + put, len);
+			put += len;
+		}
+		return n;
+	}
+
+	// }}}
+
+	// {{{ positioning
+
+	// only the read position can be moved
+	pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+	                 std::ios_base::openmode which = std::ios_base::in | std::ios_base::out) override
+	{
+		if((which & std::ios_base::out) || !(which & std::ios_base::in)) {
+			return pos_type(off_type(-1));
+		}
+
+		this->drop_get();
+		this->sync_put();
+
+		off_type base = 0;
+		if(dir == std::ios_base::cur) {
+			base = m_popped + static_cast<off_type>(m_get_idx);
+		} else if(dir == std::ios_base::end) {
+			base = m_popped + static_cast<off_type>(m_ring->size());
+		}
+
+		auto target = base + off;
+		if(target < m_popped || target > m_popped + static_cast<off_type>(m_ring->size())) {
+			return pos_type(off_type(-1));
+		}
+
+		m_get_idx = static_cast<size_type>(target - m_popped);
+		return pos_type(target);
+	}
+
+	pos_type seekpos(pos_type pos,
+	                 std::ios_base::openmode which = std::ios_base::in | std::ios_base::out) override
+	{
+		return this->seekoff(off_type(pos), std::ios_base::beg, which);
+	}
+
+	// }}}
+
+	int sync() override
+	{
+		this->sync_put();
+		this->discard_read();
+		return 0;
+	}
+
+public: // methods
+
+	explicit ring_streambuf(ring_type& ring)
+		: m_ring(std::addressof(ring)), m_get_idx(0), m_popped(0)
+	{
+	}
+
+	ring_streambuf(const ring_streambuf&) = delete;
+	ring_streambuf& operator=(const ring_streambuf&) = delete;
+
+	~ring_streambuf() override
+	{
+		this->sync();
+	}
+
+	// the ring written to and read from
+	// note: call pubsync() first to bring it up to date
+	ring_type& ring()
+	{
+		return *m_ring;
+	}
+
+};
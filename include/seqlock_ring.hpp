@@ -0,0 +1,182 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Overwriting ring with one writer, where readers take consistent snapshots
+ * of the latest values without ever blocking the writer.
+ *
+ * The writer publishes a sequence counter, as in a seqlock: it is odd while
+ * a value is being written, and even once it is done, and counts two per
+ * value. A reader reads the counter, copies the values it wants, then reads
+ * the counter again. Unlike a plain seqlock, only the slots the reader
+ * copied matter, so the copy is only retried if the writer got round to
+ * overwriting one of them, rather than after any write at all. Reading less
+ * than the whole ring leaves slack, so readers rarely retry.
+ *
+ * Values are copied while they may be written, so must be trivially
+ * copyable, and slots are atomic_slots, so a copy which races with a write is
+ * only torn (and retried), rather than a data race.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * template <typename T, typename Allocator = std::allocator<T>>
+ * class seqlock_ring
+ * {
+ * public:
+ *
+ *      explicit seqlock_ring(size_type capacity, const allocator_type& alloc = allocator_type());
+ *
+ *      // writer thread only
+ *      void push(const T& value);
+ *
+ *      // any thread
+ *      size_type latest(T* out, size_type count) const; // oldest first
+ *      bool try_latest(T* out, size_type count, size_type& copied) const;
+ *
+ *      std::uint64_t written() const;
+ *      size_type capacity() const;
+ * };
+ *
+ * \endcode
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#include "atomic_slots.hpp"
+#include "cache_padded.hpp"
+
+template <typename T, typename Allocator = std::allocator<T>>
+class seqlock_ring
+{
+private: // internal statics
+
+	static_assert(std::is_trivially_copyable<T>::value,
+	              "values are copied out while they may be written, so must be trivially copyable");
+
+	using atraits = typename std::allocator_traits<Allocator>;
+
+public: // statics
+
+	using allocator_type = Allocator;
+	using value_type     = T;
+	using size_type      = typename atraits::size_type;
+
+private: // variables
+
+	// one slot more than the capacity, so the latest `capacity' values can
+	// be read while the next is written
+	atomic_slots<T, Allocator> slots;
+	size_type cap;
+
+	// 2 * values written, plus 1 while writing
+	cache_padded<std::atomic<std::uint64_t>> m_seq;
+
+private: // internal methods
+
+	// {{{ internal methods
+
+	size_type slot_count() const
+	{
+		return cap + 1;
+	}
+
+	size_type slot_of(std::uint64_t n) const
+	{
+		return static_cast<size_type>(n % this->slot_count());
+	}
+
+	// }}}
+
+public: // methods
+
+	explicit seqlock_ring(size_type capacity, const allocator_type& alloc = allocator_type())
+		: slots(capacity + 1, alloc), cap(capacity)
+	{
+		m_seq.val.store(0, std::memory_order_relaxed);
+	}
+
+	seqlock_ring(const seqlock_ring&) = delete;
+	seqlock_ring& operator=(const seqlock_ring&) = delete;
+
+	// writer thread only
+	// never waits for readers
+	void push(const T& value)
+	{
+		auto seq = m_seq.val.load(std::memory_order_relaxed);
+		auto n = seq / 2;
+
+		m_seq.val.store(seq + 1, std::memory_order_relaxed);
+		// readers check m_seq after copying, so it must be visible before
+		// the slot is changed
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		slots.store(this->slot_of(n), value);
+		m_seq.val.store(seq + 2, std::memory_order_release);
+	}
+
+	// any thread
+	// one attempt at copying the latest count values to out, oldest first
+	// false if the writer overwrote some while copying, otherwise copied is
+	// set to the number copied, which is less than count if fewer have been
+	// written
+	bool try_latest(T* out, size_type count, size_type& copied) const
+	{
+		if(count > cap) {
+			count = cap;
+		}
+
+		// an odd (in progress) write isn't published yet
+		auto published = m_seq.val.load(std::memory_order_acquire) / 2;
+		if(published < count) {
+			count = static_cast<size_type>(published);
+		}
+
+		auto first = published - count;
+		for(size_type i = 0; i < count; ++i) {
+			slots.load(this->slot_of(first + i), out[i]);
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		// writes started since, including one in progress
+		auto started = (m_seq.val.load(std::memory_order_relaxed) + 1) / 2;
+
+		// write n goes in the slot of n - slot_count, so is only torn if
+		// that was copied
+		if(started > first + this->slot_count()) {
+			return false;
+		}
+		copied = count;
+		return true;
+	}
+
+	// any thread
+	// copy the latest count values to out, oldest first, retrying until a
+	// copy isn't torn. returns the number copied
+	size_type latest(T* out, size_type count) const
+	{
+		size_type copied = 0;
+		while(!this->try_latest(out, count, copied)) {
+		}
+		return copied;
+	}
+
+	// number of values pushed
+	std::uint64_t written() const
+	{
+		return m_seq.val.load(std::memory_order_acquire) / 2;
+	}
+
+	size_type capacity() const
+	{
+		return cap;
+	}
+};
@@ -0,0 +1,378 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Per-thread sharded rings, drained together by a collector.
+ *
+ * Each producing thread gets its own shard, a bounded spsc_ring, the first
+ * time it pushes. After that, pushing only touches the thread's own shard,
+ * so producers never contend with each other, and only share a cache line
+ * with the collector when it drains their shard.
+ *
+ * collect() drains every shard. Values from one shard come out in the order
+ * they were pushed, but shards are not ordered relative to each other,
+ * unless collect_merged() is used to k-way merge them by a key, such as a
+ * timestamp.
+ *
+ * When a shard is full, push() drops the value and counts it, rather than
+ * waiting on the collector.
+ *
+ * When a thread exits, its shards are retired, and the collector frees them
+ * once it has drained them, so a long-lived ring fed by a changing set of
+ * threads (e.g. a thread pool which replaces its workers) only keeps shards
+ * for threads which are still running, or whose values haven't been
+ * collected yet.
+ *
+ * Each thread finds its shard through a small thread-local list, one entry
+ * per ring it has pushed to. Destroying a ring bumps a global epoch, and
+ * threads drop their entries for destroyed rings the next time they push,
+ * so a thread which pushes to many short-lived rings doesn't keep them all.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * template <typename T, typename Allocator = std::allocator<T>>
+ * class sharded_ring
+ * {
+ * public:
+ *
+ *      explicit sharded_ring(size_type shard_capacity);
+ *
+ *      // any thread
+ *      bool push(const T& value);      // and T&&, false if dropped
+ *
+ *      // one collector thread at a time
+ *      template <typename F> size_type collect(F f);                     // f(T&&)
+ *      template <typename F, typename Key> size_type collect_merged(F f, Key key);
+ *
+ *      size_type shard_count() const; // including exited threads', until collected
+ *      size_type dropped() const;
+ *
+ *      static size_type local_shard_count(); // this thread's cached lookups
+ * };
+ *
+ * \endcode
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "ring_buffer.hpp"
+#include "spsc_ring.hpp"
+
+template <typename T, typename Allocator = std::allocator<T>>
+class sharded_ring
+{
+public: // statics
+
+	using allocator_type = Allocator;
+	using value_type     = T;
+	using size_type      = typename std::allocator_traits<Allocator>::size_type;
+
+private: // internal statics
+
+	struct shard
+	{
+		spsc_ring<T, Allocator> values;
+		std::atomic<size_type> dropped;
+		// set when the producing thread exits, so no more values come
+		std::atomic<bool> retired;
+
+		shard(size_type cap, const Allocator& alloc)
+			: values(cap, alloc)
+		{
+			dropped.store(0, std::memory_order_relaxed);
+			retired.store(false, std::memory_order_relaxed);
+		}
+	};
+
+	// this thread's shards, one per sharded_ring it has pushed to
+	// rings are told apart by id, which are never reused, so entries for
+	// destroyed rings are never matched
+	struct local_entry
+	{
+		std::uint64_t id;
+		shard* s;
+	};
+
+	struct local_cache
+	{
+		ring_buffer<local_entry> entries;
+		// live().epoch when entries were last pruned
+		std::uint64_t epoch;
+
+		local_cache()
+			: entries(), epoch(0)
+		{
+		}
+
+		// the thread is exiting, so retire its shards of rings which are
+		// still alive. under the lock, so those rings can't be destroyed
+		// meanwhile
+		~local_cache()
+		{
+			auto& rings = live();
+			std::lock_guard<std::mutex> guard(rings.lock);
+			for(auto& entry : entries) {
+				if(std::binary_search(rings.ids.begin(), rings.ids.end(), entry.id)) {
+					entry.s->retired.store(true, std::memory_order_release);
+				}
+			}
+		}
+	};
+
+	// ids of rings which haven't been destroyed, so threads can prune their
+	// entries for the rest
+	struct live_rings
+	{
+		std::mutex lock;
+		// sorted, since ids are handed out under the lock
+		ring_buffer<std::uint64_t> ids;
+		std::uint64_t last_id;
+		// bumped when a ring is destroyed
+		std::atomic<std::uint64_t> epoch;
+
+		live_rings()
+			: lock(), ids(), last_id(0)
+		{
+			epoch.store(0, std::memory_order_relaxed);
+		}
+	};
+
+	static local_cache& local_shards()
+	{
+		static thread_local local_cache cache;
+		return cache;
+	}
+
+	static live_rings& live()
+	{
+		static live_rings rings;
+		return rings;
+	}
+
+private: // variables
+
+	std::uint64_t id;
+	size_type shard_cap;
+	Allocator mm; // `memory manager'
+
+	// guards shards, only locked to add a shard or collect
+	mutable std::mutex registry;
+	ring_buffer<std::unique_ptr<shard>> shards;
+	// dropped by shards which have been freed
+	size_type m_retired_dropped;
+
+private: // internal methods
+
+	// {{{ internal methods
+
+	// drop this thread's entries for destroyed rings
+	static void prune(local_cache& cache, std::uint64_t epoch)
+	{
+		auto& rings = live();
+		std::lock_guard<std::mutex> guard(rings.lock);
+		erase_if(cache.entries, [&](const local_entry& entry) {
+			return !std::binary_search(rings.ids.begin(), rings.ids.end(), entry.id);
+		});
+		cache.epoch = epoch;
+	}
+
+	// free retired shards which have been drained
+	// ensure: registry is locked
+	void free_retired()
+	{
+		erase_if(shards, [&](const std::unique_ptr<shard>& s) {
+			// retired first, so every value pushed is visible to empty()
+			if(!s->retired.load(std::memory_order_acquire) || !s->values.empty()) {
+				return false;
+			}
+			m_retired_dropped += s->dropped.load(std::memory_order_relaxed);
+			return true;
+		});
+	}
+
+	shard& local_shard()
+	{
+		auto& cache = local_shards();
+		auto& entries = cache.entries;
+
+		// only changes when a ring is destroyed, so this is rarely taken
+		auto epoch = live().epoch.load(std::memory_order_relaxed);
+		if(epoch != cache.epoch) {
+			prune(cache, epoch);
+		}
+
+		// newest first, threads usually push to the ring made last
+		for(auto& entry : entries) {
+			if(entry.id == id) {
+				return *entry.s;
+			}
+		}
+
+		std::unique_ptr<shard> s(new shard(shard_cap, mm));
+		auto ptr = s.get();
+		{
+			std::lock_guard<std::mutex> guard(registry);
+			shards.push_back(std::move(s));
+		}
+		entries.push_front(local_entry{ id, ptr });
+		return *ptr;
+	}
+
+	// }}}
+
+public: // methods
+
+	explicit sharded_ring(size_type shard_capacity, const allocator_type& alloc = allocator_type())
+		: id(0), shard_cap(shard_capacity), mm(alloc), m_retired_dropped(0)
+	{
+		auto& rings = live();
+		std::lock_guard<std::mutex> guard(rings.lock);
+		id = ++rings.last_id;
+		rings.ids.push_back(id);
+	}
+
+	// threads drop their entries for this ring the next time they push
+	~sharded_ring()
+	{
+		auto& rings = live();
+		std::lock_guard<std::mutex> guard(rings.lock);
+		auto it = std::lower_bound(rings.ids.begin(), rings.ids.end(), id);
+		rings.ids.erase(it);
+		rings.epoch.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	sharded_ring(const sharded_ring&) = delete;
+	sharded_ring& operator=(const sharded_ring&) = delete;
+
+	// {{{ producers
+
+	// any thread
+	// false if this thread's shard is full, and the value was dropped
+	bool push(const value_type& value)
+	{
+		auto& s = this->local_shard();
+		if(!s.values.try_push(value)) {
+			s.dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		return true;
+	}
+
+	// any thread
+	// false if this thread's shard is full, and the value was dropped
+	bool push(value_type&& value)
+	{
+		auto& s = this->local_shard();
+		if(!s.values.try_push(std::move(value))) {
+			s.dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		return true;
+	}
+
+	// }}}
+
+	// {{{ collector
+
+	// one collector at a time
+	// drain every shard with f(T&&), a shard at a time, then free the
+	// shards of exited threads
+	// returns the number of values drained
+	template <typename F>
+	size_type collect(F f)
+	{
+		std::lock_guard<std::mutex> guard(registry);
+
+		size_type count = 0;
+		for(auto& s : shards) {
+			count += s->values.consume_all(f);
+		}
+		this->free_retired();
+		return count;
+	}
+
+	// one collector at a time
+	// drain every shard with f(T&&), in order of key(const T&) across shards
+	// assumes each shard is already in key order, e.g. timestamps taken
+	// when pushing. returns the number of values drained
+	template <typename F, typename Key>
+	size_type collect_merged(F f, Key key)
+	{
+		std::lock_guard<std::mutex> guard(registry);
+
+		// drain first, so the merge works on a snapshot
+		std::vector<ring_buffer<T>> runs(shards.size());
+		size_type count = 0;
+		for(size_type i = 0; i < shards.size(); ++i) {
+			auto& run = runs[i];
+			count += shards[i]->values.consume_all([&](T&& val) { run.push_back(std::move(val)); });
+		}
+		this->free_retired();
+
+		// heap of runs, by their front value
+		std::vector<ring_buffer<T>*> heap;
+		for(auto& run : runs) {
+			if(!run.empty()) {
+				heap.push_back(&run);
+			}
+		}
+		auto later = [&](const ring_buffer<T>* lhs, const ring_buffer<T>* rhs) {
+			return key(rhs->front()) < key(lhs->front());
+		};
+		std::make_heap(heap.begin(), heap.end(), later);
+
+		while(!heap.empty()) {
+			std::pop_heap(heap.begin(), heap.end(), later);
+			auto run = heap.back();
+
+			f(std::move(run->front()));
+			run->pop_front();
+
+			if(run->empty()) {
+				heap.pop_back();
+			} else {
+				std::push_heap(heap.begin(), heap.end(), later);
+			}
+		}
+		return count;
+	}
+
+	// }}}
+
+	// entries this thread keeps to find its shards, including ones for
+	// destroyed rings which haven't been pruned yet
+	static size_type local_shard_count()
+	{
+		return local_shards().entries.size();
+	}
+
+	// shards of running threads, and of exited threads until collected
+	size_type shard_count() const
+	{
+		std::lock_guard<std::mutex> guard(registry);
+		return shards.size();
+	}
+
+	// values dropped because their shard was full
+	size_type dropped() const
+	{
+		std::lock_guard<std::mutex> guard(registry);
+
+		size_type count = m_retired_dropped;
+		for(const auto& s : shards) {
+			count += s->dropped.load(std::memory_order_relaxed);
+		}
+		return count;
+	}
+};
@@ -0,0 +1,641 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Struct-of-arrays ring buffer: each field of a record is stored in its own
+ * wrap-around array, and all of them share one begin and end.
+ *
+ * Scanning one field only touches that field's array, instead of every
+ * record, so e.g. summing one 8-byte field of a 32-byte record uses a
+ * quarter of the memory bandwidth. Each column is exposed as the (at most
+ * two) contiguous segments its values are in, as with ring_buffer's
+ * first_segment() and second_segment(), so scans can be plain loops over
+ * arrays, which compilers vectorise.
+ *
+ * Indexing and iterating gives proxy references, tuples of references to
+ * each field, so range-for works, e.g.
+ *
+ *     for(auto rec : ticks) {
+ *             std::get<1>(rec) *= 2;
+ *     }
+ *
+ * or with C++17 structured bindings, `for(auto [ts, price, qty, flags] : ticks)'.
+ *
+ * As with ring_buffer, the arrays have one more slot than the capacity, to
+ * tell a full ring from an empty one. Memory comes from std::allocator.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * template <typename... Ts>
+ * class soa_ring_buffer
+ * {
+ * public:
+ *
+ *      using value_type      = std::tuple<Ts...>;
+ *      using reference       = std::tuple<Ts&...>;
+ *      using const_reference = std::tuple<const Ts&...>;
+ *
+ *      soa_ring_buffer();
+ *      explicit soa_ring_buffer(size_type cap);
+ *
+ *      reference operator[](size_type pos);
+ *      reference front();
+ *      reference back();
+ *      template <std::size_t I> column_type<I>& get(size_type pos);
+ *
+ *      template <std::size_t I> std::pair<column_type<I>*, size_type> first_segment();
+ *      template <std::size_t I> std::pair<column_type<I>*, size_type> second_segment();
+ *
+ *      iterator begin();
+ *      iterator end();
+ *
+ *      bool empty() const;
+ *      size_type size() const;
+ *      size_type capacity() const;
+ *      void reserve(size_type new_cap);
+ *
+ *      template <typename... Us> void push_back(Us&&... fields);  // one per column
+ *      template <typename... Us> void push_front(Us&&... fields);
+ *      void pop_front();
+ *      void pop_back();
+ *      void clear();
+ *      void swap(soa_ring_buffer& other);
+ * };
+ *
+ * \endcode
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "index_iterator.hpp"
+
+namespace soa_ring_buffer_detail {
+
+// std::index_sequence is C++14
+template <std::size_t... Is>
+struct index_seq
+{
+};
+
+template <std::size_t N, std::size_t... Is>
+struct make_index_seq : make_index_seq<N - 1, N - 1, Is...>
+{
+};
+
+template <std::size_t... Is>
+struct make_index_seq<0, Is...>
+{
+	using type = index_seq<Is...>;
+};
+
+// evaluate an expression for each element of a pack, in order
+using expand = int[];
+
+// std::conjunction is C++17
+template <bool... Bs>
+struct bool_pack
+{
+};
+
+template <bool... Bs>
+using all_true = std::is_same<bool_pack<true, Bs...>, bool_pack<Bs..., true>>;
+
+// an rvalue if Move, so values are moved, otherwise an lvalue, so they are
+// copied, unless they can only be moved
+template <bool Move, typename U>
+typename std::conditional<Move || !std::is_copy_constructible<U>::value, U&&, const U&>::type move_if(U& val)
+{
+	return std::move(val);
+}
+
+} // namespace soa_ring_buffer_detail
+
+template <typename... Ts>
+class soa_ring_buffer
+{
+private: // internal statics
+
+	static_assert(sizeof...(Ts) > 0, "soa_ring_buffer needs at least one column");
+
+	using indices = typename soa_ring_buffer_detail::make_index_seq<sizeof...(Ts)>::type;
+
+public: // statics
+
+	// {{{ member types
+
+	using value_type             = std::tuple<Ts...>;
+
+	using size_type              = std::size_t;
+	using difference_type        = std::ptrdiff_t;
+
+	// proxies, a reference to each field
+	using reference              = std::tuple<Ts&...>;
+	using const_reference        = std::tuple<const Ts&...>;
+
+	template <std::size_t I>
+	using column_type            = typename std::tuple_element<I, value_type>::type;
+
+	using iterator               = index_iterator<soa_ring_buffer, void>;
+	using const_iterator         = index_iterator<const soa_ring_buffer, void>;
+
+	// }}}
+
+private: // internal statics
+
+	// as with ring_buffer
+	static constexpr double expansion_ratio = 1.5;
+
+	// growing moves values only if no column's move can throw, otherwise a
+	// throw part way through would leave earlier columns moved from
+	using nothrow_move = soa_ring_buffer_detail::all_true<std::is_nothrow_move_constructible<Ts>::value...>;
+
+private: // variables
+
+	// one array per column, each of mb_size slots
+	std::tuple<Ts*...> cols;
+	size_type mb_size;
+
+	// begin and end idx of values, shared by all columns
+	size_type m_begin;
+	size_type m_end;
+
+private: // internal methods
+
+	// {{{ internal methods
+
+	size_type offset_of(size_type idx) const
+	{
+		return (m_begin + idx) % mb_size;
+	}
+
+	// {{{ per column
+
+	// if one column can't be allocated, the others are freed
+	template <std::size_t... Is>
+	static std::tuple<Ts*...> alloc_cols(size_type count, soa_ring_buffer_detail::index_seq<Is...>)
+	{
+		std::tuple<Ts*...> blk; // null
+		try {
+			(void)soa_ring_buffer_detail::expand{ 0, (std::get<Is>(blk) = std::allocator<Ts>().allocate(count), 0)... };
+		} catch(...) {
+			free_cols(blk, count, soa_ring_buffer_detail::index_seq<Is...>());
+			throw;
+		}
+		return blk;
+	}
+
+	// skips columns which weren't allocated
+	template <std::size_t... Is>
+	static void free_cols(std::tuple<Ts*...>& blk, size_type count, soa_ring_buffer_detail::index_seq<Is...>)
+	{
+		(void)soa_ring_buffer_detail::expand{ 0,
+			(std::get<Is>(blk) != nullptr ? (std::allocator<Ts>().deallocate(std::get<Is>(blk), count), 0) : 0)... };
+	}
+
+	// destroy the first count values of a column array
+	template <std::size_t I>
+	static void dtor_run(column_type<I>* first, size_type count)
+	{
+		using U = column_type<I>;
+		for(size_type i = 0; i < count; ++i) {
+			first[i].~U();
+		}
+	}
+
+	// if a field's constructor throws, the fields before it are destroyed
+	template <std::size_t... Is, typename... Us>
+	void ctor_at(size_type off, soa_ring_buffer_detail::index_seq<Is...>, Us&&... fields)
+	{
+		std::size_t done = 0;
+		try {
+			(void)soa_ring_buffer_detail::expand{ 0,
+				((void)::new(static_cast<void*>(std::get<Is>(cols) + off)) Ts(std::forward<Us>(fields)), ++done, 0)... };
+		} catch(...) {
+			(void)soa_ring_buffer_detail::expand{ 0,
+				(Is < done ? (dtor_run<Is>(std::get<Is>(cols) + off, 1), 0) : 0)... };
+			throw;
+		}
+	}
+
+	template <std::size_t... Is>
+	void dtor_at(size_type off, soa_ring_buffer_detail::index_seq<Is...>)
+	{
+		(void)soa_ring_buffer_detail::expand{ 0, (std::get<Is>(cols)[off].~Ts(), 0)... };
+	}
+
+	template <std::size_t... Is>
+	reference ref_at(size_type off, soa_ring_buffer_detail::index_seq<Is...>)
+	{
+		return reference(std::get<Is>(cols)[off]...);
+	}
+
+	template <std::size_t... Is>
+	const_reference ref_at(size_type off, soa_ring_buffer_detail::index_seq<Is...>) const
+	{
+		return const_reference(std::get<Is>(cols)[off]...);
+	}
+
+	// move (or copy, see nothrow_move) every value of column I to the start
+	// of dst, leaving the source to be destroyed. if this throws, dst is
+	// left empty
+	template <std::size_t I>
+	void move_column(column_type<I>* dst, std::true_type /* trivial */)
+	{
+		auto one = this->template first_segment<I>();
+		auto two = this->template second_segment<I>();
+		if(one.second > 0) {
+			std::memcpy(static_cast<void*>(dst), one.first, one.second * sizeof(column_type<I>));
+		}
+		if(two.second > 0) {
+			std::memcpy(static_cast<void*>(dst + one.second), two.first, two.second * sizeof(column_type<I>));
+		}
+	}
+
+	template <std::size_t I>
+	void move_column(column_type<I>* dst, std::false_type /* trivial */)
+	{
+		using U = column_type<I>;
+		auto src = std::get<I>(cols);
+		size_type i = 0;
+		try {
+			for(auto count = this->size(); i < count; ++i) {
+				::new(static_cast<void*>(dst + i)) U(soa_ring_buffer_detail::move_if<nothrow_move::value>(src[this->offset_of(i)]));
+			}
+		} catch(...) {
+			dtor_run<I>(dst, i);
+			throw;
+		}
+	}
+
+	// move every value to the start of dst, leaving the sources to be
+	// destroyed. if this throws, dst is left empty
+	template <std::size_t... Is>
+	void move_into(std::tuple<Ts*...>& dst, soa_ring_buffer_detail::index_seq<Is...>)
+	{
+		std::size_t done = 0;
+		try {
+			(void)soa_ring_buffer_detail::expand{ 0,
+				(this->template move_column<Is>(std::get<Is>(dst), std::is_trivially_copyable<Ts>()), ++done, 0)... };
+		} catch(...) {
+			(void)soa_ring_buffer_detail::expand{ 0,
+				(Is < done ? (dtor_run<Is>(std::get<Is>(dst), this->size()), 0) : 0)... };
+			throw;
+		}
+	}
+
+	// copy every value of column I from other, to the start of this
+	// if this throws, the column is left empty
+	template <std::size_t I>
+	void copy_column(const soa_ring_buffer& other)
+	{
+		using U = column_type<I>;
+		auto src = std::get<I>(other.cols);
+		auto dst = std::get<I>(cols);
+		size_type i = 0;
+		try {
+			for(auto count = other.size(); i < count; ++i) {
+				::new(static_cast<void*>(dst + i)) U(src[other.offset_of(i)]);
+			}
+		} catch(...) {
+			dtor_run<I>(dst, i);
+			throw;
+		}
+	}
+
+	// if this throws, every column is left empty
+	template <std::size_t... Is>
+	void copy_from(const soa_ring_buffer& other, soa_ring_buffer_detail::index_seq<Is...>)
+	{
+		std::size_t done = 0;
+		try {
+			(void)soa_ring_buffer_detail::expand{ 0, (this->template copy_column<Is>(other), ++done, 0)... };
+		} catch(...) {
+			(void)soa_ring_buffer_detail::expand{ 0,
+				(Is < done ? (dtor_run<Is>(std::get<Is>(cols), other.size()), 0) : 0)... };
+			throw;
+		}
+	}
+
+	// }}}
+
+	void dtor_all()
+	{
+		for(size_type i = 0, count = this->size(); i < count; ++i) {
+			this->dtor_at(this->offset_of(i), indices());
+		}
+		m_begin = m_end = 0;
+	}
+
+	// move all values to new arrays with capacity `cap'
+	// the old values are only destroyed once every column has moved, so if
+	// this throws, the ring is unchanged
+	void realloc_move(size_type cap)
+	{
+		// ensure: cap >= this->size()
+		auto count = this->size();
+		auto new_cols = alloc_cols(cap + 1, indices());
+		try {
+			this->move_into(new_cols, indices());
+		} catch(...) {
+			free_cols(new_cols, cap + 1, indices());
+			throw;
+		}
+
+		this->dtor_all();
+		free_cols(cols, mb_size, indices());
+		cols = new_cols;
+		mb_size = cap + 1;
+		m_begin = 0;
+		m_end = count;
+	}
+
+	// capacity to grow to, to fit at least count
+	size_type extra_capacity(size_type count) const
+	{
+		auto new_size = static_cast<size_type>(static_cast<double>(mb_size) * expansion_ratio);
+		return count > new_size ? count : new_size;
+	}
+
+	// logic for push_front() and push_back() when full
+	// the fields may refer to values in this ring, so are copied out first
+	template <std::size_t... Is>
+	void push_grow(bool front, value_type&& fields, soa_ring_buffer_detail::index_seq<Is...>)
+	{
+		this->realloc_move(this->extra_capacity(this->size() + 1));
+		if(front) {
+			this->push_front(std::get<Is>(std::move(fields))...);
+		} else {
+			this->push_back(std::get<Is>(std::move(fields))...);
+		}
+	}
+
+	// }}}
+
+public: // methods
+
+	// {{{ basic functions
+
+	soa_ring_buffer()
+		: cols(), mb_size(0), m_begin(0), m_end(0)
+	{
+	}
+
+	// blank, but with capacity
+	explicit soa_ring_buffer(size_type cap)
+		: cols(alloc_cols(cap + 1, indices())), mb_size(cap + 1), m_begin(0), m_end(0)
+	{
+	}
+
+	// if a copy throws, the delegated-to constructor has finished, so the
+	// destructor frees the arrays
+	soa_ring_buffer(const soa_ring_buffer& other)
+		: soa_ring_buffer(other.size())
+	{
+		this->copy_from(other, indices());
+		m_end = other.size();
+	}
+
+	soa_ring_buffer(soa_ring_buffer&& other) noexcept
+		: cols(other.cols), mb_size(other.mb_size), m_begin(other.m_begin), m_end(other.m_end)
+	{
+		other.cols = std::tuple<Ts*...>();
+		other.mb_size = other.m_begin = other.m_end = 0;
+	}
+
+	// copy and swap, or plain swap
+	soa_ring_buffer& operator=(soa_ring_buffer other)
+	{
+		this->swap(other);
+		return *this;
+	}
+
+	~soa_ring_buffer()
+	{
+		this->dtor_all();
+		free_cols(cols, mb_size, indices());
+	}
+
+	// }}}
+
+	// {{{ element access
+
+	reference operator[](size_type pos)
+	{
+		return this->ref_at(this->offset_of(pos), indices());
+	}
+
+	const_reference operator[](size_type pos) const
+	{
+		return this->ref_at(this->offset_of(pos), indices());
+	}
+
+	reference front()
+	{
+		return (*this)[0];
+	}
+
+	const_reference front() const
+	{
+		return (*this)[0];
+	}
+
+	reference back()
+	{
+		return (*this)[this->size() - 1];
+	}
+
+	const_reference back() const
+	{
+		return (*this)[this->size() - 1];
+	}
+
+	// field I of the value at pos
+	template <std::size_t I>
+	column_type<I>& get(size_type pos)
+	{
+		return std::get<I>(cols)[this->offset_of(pos)];
+	}
+
+	template <std::size_t I>
+	const column_type<I>& get(size_type pos) const
+	{
+		return std::get<I>(cols)[this->offset_of(pos)];
+	}
+
+	// column I, as the (at most two) contiguous runs its values are in
+	// second_segment() is empty unless the values wrap around
+	template <std::size_t I>
+	std::pair<column_type<I>*, size_type> first_segment()
+	{
+		bool wraps = m_end < m_begin;
+		return { std::get<I>(cols) + m_begin, (wraps ? mb_size : m_end) - m_begin };
+	}
+
+	template <std::size_t I>
+	std::pair<const column_type<I>*, size_type> first_segment() const
+	{
+		bool wraps = m_end < m_begin;
+		return { std::get<I>(cols) + m_begin, (wraps ? mb_size : m_end) - m_begin };
+	}
+
+	template <std::size_t I>
+	std::pair<column_type<I>*, size_type> second_segment()
+	{
+		bool wraps = m_end < m_begin;
+		return { std::get<I>(cols), wraps ? m_end : 0 };
+	}
+
+	template <std::size_t I>
+	std::pair<const column_type<I>*, size_type> second_segment() const
+	{
+		bool wraps = m_end < m_begin;
+		return { std::get<I>(cols), wraps ? m_end : 0 };
+	}
+
+	// }}}
+
+	// {{{ iterators
+
+	iterator begin()
+	{
+		return iterator(this, 0);
+	}
+
+	const_iterator begin() const
+	{
+		return this->cbegin();
+	}
+
+	const_iterator cbegin() const
+	{
+		return const_iterator(this, 0);
+	}
+
+	iterator end()
+	{
+		return iterator(this, this->size());
+	}
+
+	const_iterator end() const
+	{
+		return this->cend();
+	}
+
+	const_iterator cend() const
+	{
+		return const_iterator(this, this->size());
+	}
+
+	// }}}
+
+	// {{{ capacity
+
+	bool empty() const
+	{
+		return m_begin == m_end;
+	}
+
+	size_type size() const
+	{
+		if(mb_size == 0) {
+			return 0;
+		}
+		return (m_end + mb_size - m_begin) % mb_size;
+	}
+
+	size_type capacity() const
+	{
+		return mb_size == 0 ? 0 : mb_size - 1;
+	}
+
+	// invalidates: all (if capacity changes)
+	void reserve(size_type new_cap)
+	{
+		if(new_cap > this->capacity()) {
+			this->realloc_move(new_cap);
+		}
+	}
+
+	// }}}
+
+	// {{{ modifiers
+
+	// keeps capacity
+	void clear()
+	{
+		this->dtor_all();
+	}
+
+	// one field per column
+	// invalidates: all (if capacity changes)
+	template <typename... Us>
+	void push_back(Us&&... fields)
+	{
+		static_assert(sizeof...(Us) == sizeof...(Ts), "push_back needs one value per column");
+
+		if(this->size() + 1 > this->capacity()) {
+			this->push_grow(false, value_type(std::forward<Us>(fields)...), indices());
+			return;
+		}
+		this->ctor_at(m_end, indices(), std::forward<Us>(fields)...);
+		m_end = (m_end + 1) % mb_size;
+	}
+
+	// one field per column
+	// invalidates: all (if capacity changes)
+	template <typename... Us>
+	void push_front(Us&&... fields)
+	{
+		static_assert(sizeof...(Us) == sizeof...(Ts), "push_front needs one value per column");
+
+		if(this->size() + 1 > this->capacity()) {
+			this->push_grow(true, value_type(std::forward<Us>(fields)...), indices());
+			return;
+		}
+		auto new_begin = (m_begin + mb_size - 1) % mb_size;
+		this->ctor_at(new_begin, indices(), std::forward<Us>(fields)...);
+		m_begin = new_begin;
+	}
+
+	void pop_front()
+	{
+		// ensure: this->size() > 0
+		this->dtor_at(m_begin, indices());
+		m_begin = (m_begin + 1) % mb_size;
+	}
+
+	void pop_back()
+	{
+		// ensure: this->size() > 0
+		auto new_end = (m_end + mb_size - 1) % mb_size;
+		this->dtor_at(new_end, indices());
+		m_end = new_end;
+	}
+
+	void swap(soa_ring_buffer& other)
+	{
+		using std::swap;
+		swap(cols, other.cols);
+		swap(mb_size, other.mb_size);
+		swap(m_begin, other.m_begin);
+		swap(m_end, other.m_end);
+	}
+
+	// }}}
+
+	friend void swap(soa_ring_buffer& lhs, soa_ring_buffer& rhs)
+	{
+		lhs.swap(rhs);
+	}
+};
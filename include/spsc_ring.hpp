@@ -0,0 +1,243 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Bounded single producer, single consumer ring, safe to use from two
+ * threads without locks.
+ *
+ * The producer owns the tail and the consumer owns the head, and each keeps
+ * a cached copy of the other's index, so the other's cache line is only
+ * read when the ring looks full (or empty). The capacity is rounded up to
+ * a power of two, so positions can be masked instead of wrapped.
+ *
+ * Unlike ring_buffer, the capacity is fixed, and there is no random access.
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * template <typename T, typename Allocator = std::allocator<T>>
+ * class spsc_ring
+ * {
+ * public:
+ *
+ *      explicit spsc_ring(size_type capacity, const allocator_type& alloc = allocator_type());
+ *
+ *      // producer thread only
+ *      bool try_push(const T& value); // and T&&
+ *      template <typename... Args> bool try_emplace(Args&&... args);
+ *
+ *      // consumer thread only
+ *      bool try_pop(T& out);
+ *      template <typename F> size_type consume_all(F f); // f(T&&)
+ *
+ *      // either thread, approximate while the other is active
+ *      bool empty() const;
+ *      size_type size() const;
+ *      size_type capacity() const;
+ * };
+ *
+ * \endcode
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "cache_padded.hpp"
+
+template <typename T, typename Allocator = std::allocator<T>>
+class spsc_ring
+{
+private: // internal statics
+
+	using atraits = typename std::allocator_traits<Allocator>;
+
+	static_assert(std::is_same<T, typename atraits::value_type>::value,
+	              "Allocator must use the same type as T");
+
+public: // statics
+
+	using allocator_type = typename atraits::allocator_type;
+	using value_type     = T;
+	using size_type      = typename atraits::size_type;
+	using pointer        = typename atraits::pointer;
+
+private: // internal statics
+
+	// the index each side owns, and its cache of the other side's index
+	struct side
+	{
+		std::atomic<size_type> pos;
+		size_type other;
+	};
+
+	static size_type round_up_pow2(size_type val)
+	{
+		size_type out = 1;
+		while(out < val) {
+			out *= 2;
+		}
+		return out;
+	}
+
+private: // variables
+
+	// written by the consumer, position of the next value to pop
+	cache_padded<side> m_head;
+	// written by the producer, position of the next value to push
+	cache_padded<side> m_tail;
+
+	allocator_type mm; // `memory manager'
+	pointer memblk;
+	size_type mask;
+
+private: // internal methods
+
+	pointer ptr_of(size_type pos) const
+	{
+		return memblk + (pos & mask);
+	}
+
+public: // methods
+
+	explicit spsc_ring(size_type capacity, const allocator_type& alloc = allocator_type())
+		: mm(alloc), memblk(nullptr), mask(round_up_pow2(capacity == 0 ? 1 : capacity) - 1)
+	{
+		m_head.val.pos.store(0, std::memory_order_relaxed);
+		m_head.val.other = 0;
+		m_tail.val.pos.store(0, std::memory_order_relaxed);
+		m_tail.val.other = 0;
+
+		memblk = atraits::allocate(mm, mask + 1);
+	}
+
+	spsc_ring(const spsc_ring&) = delete;
+	spsc_ring& operator=(const spsc_ring&) = delete;
+
+	// ensure: no other thread is using the ring
+	~spsc_ring()
+	{
+		auto head = m_head.val.pos.load(std::memory_order_relaxed);
+		auto tail = m_tail.val.pos.load(std::memory_order_relaxed);
+		for(; head != tail; ++head) {
+			atraits::destroy(mm, this->ptr_of(head));
+		}
+		atraits::deallocate(mm, memblk, mask + 1);
+	}
+
+	// {{{ producer
+
+	// producer thread only
+	// false if full
+	template <typename... Args>
+	bool try_emplace(Args&&... args)
+	{
+		auto tail = m_tail.val.pos.load(std::memory_order_relaxed);
+		if(tail - m_tail.val.other > mask) {
+			// looks full, check the real head
+			m_tail.val.other = m_head.val.pos.load(std::memory_order_acquire);
+			if(tail - m_tail.val.other > mask) {
+				return false;
+			}
+		}
+
+		atraits::construct(mm, this->ptr_of(tail), std::forward<Args>(args)...);
+		m_tail.val.pos.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// producer thread only
+	bool try_push(const value_type& value)
+	{
+		return this->try_emplace(value);
+	}
+
+	// producer thread only
+	bool try_push(value_type&& value)
+	{
+		return this->try_emplace(std::move(value));
+	}
+
+	// }}}
+
+	// {{{ consumer
+
+	// consumer thread only
+	// false if empty
+	bool try_pop(value_type& out)
+	{
+		auto head = m_head.val.pos.load(std::memory_order_relaxed);
+		if(head == m_head.val.other) {
+			// looks empty, check the real tail
+			m_head.val.other = m_tail.val.pos.load(std::memory_order_acquire);
+			if(head == m_head.val.other) {
+				return false;
+			}
+		}
+
+		auto ptr = this->ptr_of(head);
+		out = std::move(*ptr);
+		atraits::destroy(mm, ptr);
+		m_head.val.pos.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer thread only
+	// pop every value pushed so far with f(T&&), freeing their slots once
+	// at the end. returns the number popped
+	// if f throws, the value it threw on counts as popped, and the rest are
+	// left for next time
+	template <typename F>
+	size_type consume_all(F f)
+	{
+		auto head = m_head.val.pos.load(std::memory_order_relaxed);
+		auto tail = m_tail.val.pos.load(std::memory_order_acquire);
+		m_head.val.other = tail;
+
+		auto pos = head;
+		try {
+			for(; pos != tail; ++pos) {
+				auto ptr = this->ptr_of(pos);
+				f(std::move(*ptr));
+				atraits::destroy(mm, ptr);
+			}
+		} catch(...) {
+			atraits::destroy(mm, this->ptr_of(pos));
+			m_head.val.pos.store(pos + 1, std::memory_order_release);
+			throw;
+		}
+		m_head.val.pos.store(tail, std::memory_order_release);
+		return tail - head;
+	}
+
+	// }}}
+
+	// {{{ capacity
+
+	// approximate while the other thread is active
+	bool empty() const
+	{
+		return this->size() == 0;
+	}
+
+	// approximate while the other thread is active
+	size_type size() const
+	{
+		auto head = m_head.val.pos.load(std::memory_order_acquire);
+		auto tail = m_tail.val.pos.load(std::memory_order_acquire);
+		return tail - head;
+	}
+
+	size_type capacity() const
+	{
+		return mask + 1;
+	}
+
+	// }}}
+};
@@ -0,0 +1,308 @@
+#pragma once
+
+/**
+ * \file
+ *
+ * Chase-Lev work-stealing deque, as described in "Correct and Efficient
+ * Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli).
+ *
+ * One owner thread pushes and pops at the bottom, and any number of thieves
+ * steal from the top with a CAS. Values are in a circular array, indexed by
+ * ever-increasing positions, which doubles when full.
+ *
+ * Thieves may still be reading the old array after it is replaced, so it
+ * can't be freed straight away. Instead it is retired, and freed once the
+ * owner sees no steal in progress (a quiescent state). Steals are short, so
+ * this happens soon after, and until then the retired arrays add up to less
+ * than the current one.
+ *
+ * Values are copied in and out of atomic slots, so must be trivially
+ * copyable (e.g. pointers to tasks).
+ */
+
+/*
+ * synopsis
+ *
+ * \code
+ *
+ * template <typename T, typename Allocator = std::allocator<T>>
+ * class work_stealing_ring
+ * {
+ * public:
+ *
+ *      explicit work_stealing_ring(size_type capacity = 64, const allocator_type& alloc = allocator_type());
+ *
+ *      // owner thread only
+ *      void push(const T& value);
+ *      bool pop(T& out);
+ *
+ *      // any thread
+ *      bool steal(T& out); // false if empty, or lost a race
+ *      bool empty() const;
+ *      size_type size() const;
+ *      size_type capacity() const;
+ * };
+ *
+ * \endcode
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#include "cache_padded.hpp"
+#include "ring_buffer.hpp"
+
+template <typename T, typename Allocator = std::allocator<T>>
+class work_stealing_ring
+{
+private: // internal statics
+
+	using atraits = typename std::allocator_traits<Allocator>;
+
+	static_assert(std::is_same<T, typename atraits::value_type>::value,
+	              "Allocator must use the same type as T");
+	static_assert(std::is_trivially_copyable<T>::value,
+	              "values are copied through atomics, so must be trivially copyable");
+
+public: // statics
+
+	using allocator_type = typename atraits::allocator_type;
+	using value_type     = T;
+	using size_type      = typename atraits::size_type;
+
+private: // internal statics
+
+	// positions only increase, so must not overflow
+	using position = std::int64_t;
+
+	using slot = std::atomic<T>;
+	using slot_alloc = typename atraits::template rebind_alloc<slot>;
+	using slot_traits = std::allocator_traits<slot_alloc>;
+
+	// circular array of 2^n slots
+	struct array
+	{
+		size_type mask;
+		typename slot_traits::pointer slots;
+
+		T get(position pos) const
+		{
+			return slots[static_cast<size_type>(pos) & mask].load(std::memory_order_relaxed);
+		}
+
+		void put(position pos, const T& value)
+		{
+			slots[static_cast<size_type>(pos) & mask].store(value, std::memory_order_relaxed);
+		}
+	};
+
+	using array_alloc = typename atraits::template rebind_alloc<array>;
+	using array_traits = std::allocator_traits<array_alloc>;
+
+private: // variables
+
+	// written by thieves, kept off the owner's cache line
+	cache_padded<std::atomic<position>> m_top;
+	// steals which might be reading an array
+	cache_padded<std::atomic<size_type>> m_stealing;
+
+	// written by the owner
+	std::atomic<position> bottom;
+	std::atomic<array*> arr;
+	slot_alloc mm; // `memory manager'
+	ring_buffer<array*, typename atraits::template rebind_alloc<array*>> retired;
+
+private: // internal methods
+
+	// {{{ internal methods
+
+	array* alloc_array(size_type cap)
+	{
+		array_alloc aa(mm);
+		auto a = array_traits::allocate(aa, 1);
+		array_traits::construct(aa, a, array());
+
+		a->mask = cap - 1;
+		a->slots = slot_traits::allocate(mm, cap);
+		for(size_type i = 0; i < cap; ++i) {
+			slot_traits::construct(mm, a->slots + i);
+		}
+		return a;
+	}
+
+	void free_array(array* a)
+	{
+		// atomic<T> of trivially copyable T needs no destruction
+		slot_traits::deallocate(mm, a->slots, a->mask + 1);
+
+		array_alloc aa(mm);
+		array_traits::destroy(aa, a);
+		array_traits::deallocate(aa, a, 1);
+	}
+
+	// free retired arrays, if no thief can still be reading them
+	void reclaim()
+	{
+		if(retired.empty() || m_stealing.val.load(std::memory_order_seq_cst) != 0) {
+			return;
+		}
+		for(auto a : retired) {
+			this->free_array(a);
+		}
+		retired.clear();
+	}
+
+	// copy values in [t, b) into an array of twice the size
+	array* grow(array* old, position b, position t)
+	{
+		auto a = this->alloc_array(2 * (old->mask + 1));
+		for(auto pos = t; pos != b; ++pos) {
+			a->put(pos, old->get(pos));
+		}
+
+		arr.store(a, std::memory_order_seq_cst);
+		retired.push_back(old);
+		this->reclaim();
+		return a;
+	}
+
+	static size_type round_up_pow2(size_type val)
+	{
+		size_type out = 1;
+		while(out < val) {
+			out *= 2;
+		}
+		return out;
+	}
+
+	// }}}
+
+public: // methods
+
+	explicit work_stealing_ring(size_type capacity = 64, const allocator_type& alloc = allocator_type())
+		: bottom(0), arr(nullptr), mm(alloc), retired(alloc)
+	{
+		m_top.val.store(0, std::memory_order_relaxed);
+		m_stealing.val.store(0, std::memory_order_relaxed);
+		arr.store(this->alloc_array(round_up_pow2(capacity < 2 ? 2 : capacity)), std::memory_order_relaxed);
+	}
+
+	work_stealing_ring(const work_stealing_ring&) = delete;
+	work_stealing_ring& operator=(const work_stealing_ring&) = delete;
+
+	// ensure: no other thread is using the ring
+	~work_stealing_ring()
+	{
+		for(auto a : retired) {
+			this->free_array(a);
+		}
+		this->free_array(arr.load(std::memory_order_relaxed));
+	}
+
+	// {{{ owner
+
+	// owner thread only
+	void push(const T& value)
+	{
+		auto b = bottom.load(std::memory_order_relaxed);
+		auto t = m_top.val.load(std::memory_order_acquire);
+		auto a = arr.load(std::memory_order_relaxed);
+
+		if(b - t > static_cast<position>(a->mask)) {
+			a = this->grow(a, b, t);
+		}
+
+		a->put(b, value);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+
+	// owner thread only
+	// take the most recently pushed value, false if empty
+	bool pop(T& out)
+	{
+		if(!retired.empty()) {
+			this->reclaim();
+		}
+
+		auto b = bottom.load(std::memory_order_relaxed) - 1;
+		auto a = arr.load(std::memory_order_relaxed);
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		auto t = m_top.val.load(std::memory_order_relaxed);
+
+		if(t > b) {
+			// empty
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		out = a->get(b);
+		if(t == b) {
+			// last value, race thieves for it
+			bool won = m_top.val.compare_exchange_strong(t, t + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed);
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return won;
+		}
+		return true;
+	}
+
+	// }}}
+
+	// {{{ thieves
+
+	// any thread
+	// take the least recently pushed value
+	// false if empty, or another thread took it first
+	bool steal(T& out)
+	{
+		m_stealing.val.fetch_add(1, std::memory_order_seq_cst);
+
+		auto t = m_top.val.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		auto b = bottom.load(std::memory_order_acquire);
+
+		bool got = false;
+		if(t < b) {
+			auto a = arr.load(std::memory_order_seq_cst);
+			auto value = a->get(t);
+			if(m_top.val.compare_exchange_strong(t, t + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				out = value;
+				got = true;
+			}
+		}
+
+		m_stealing.val.fetch_sub(1, std::memory_order_release);
+		return got;
+	}
+
+	// }}}
+
+	// {{{ capacity
+
+	// approximate if other threads are using the ring
+	bool empty() const
+	{
+		return this->size() == 0;
+	}
+
+	// approximate if other threads are using the ring
+	size_type size() const
+	{
+		auto b = bottom.load(std::memory_order_relaxed);
+		auto t = m_top.val.load(std::memory_order_relaxed);
+		return b > t ? static_cast<size_type>(b - t) : 0;
+	}
+
+	size_type capacity() const
+	{
+		return arr.load(std::memory_order_relaxed)->mask + 1;
+	}
+
+	// }}}
+};
@@ -0,0 +1,151 @@
+#include "include/broadcast_ring.hpp"
+
+/*
+ * check that every consumer sees every value, that dependent consumers wait
+ * for their dependencies, and blocking vs overwriting when full
+ */
+
+#include <cassert>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// every field is the same, so a torn value shows up as a mismatch
+struct sample
+{
+	long a, b, c, d;
+};
+
+} // namespace
+
+int main()
+{
+	{
+		broadcast_ring<std::string> ring(4);
+		auto& a = ring.add_consumer();
+		auto& b = ring.add_consumer({ &a });
+		std::vector<std::string> seen_a, seen_b;
+		auto read_a = [&](const std::string& val) { seen_a.push_back(val); };
+		auto read_b = [&](const std::string& val) { seen_b.push_back(val); };
+
+		assert((!a.try_read(read_a)) && "nothing published");
+
+		for(int i = 0; i < 4; ++i) {
+			assert((ring.try_push(std::to_string(i))) && "push until full");
+		}
+
+		assert((!ring.try_push("x")) && "should be full");
+		assert((!b.try_read(read_b)) && "b depends on a");
+		assert((a.read_batch(read_a, 3) == 3 && seen_a.size() == 3) && "batch read");
+		assert((!ring.try_push("4")) && "still full until the slowest reads");
+		assert((b.read_batch(read_b, 10) == 3) && "b should see what a has read");
+		assert((ring.try_push("4") && ring.published() == 5) && "space after all consumers read");
+
+		while(a.try_read(read_a)) {
+		}
+		while(b.try_read(read_b)) {
+		}
+
+		assert((seen_a == seen_b && seen_a.size() == 5 && seen_a[4] == "4") && "both consumers see every value");
+	}
+	{
+		// overwriting
+		broadcast_ring<int, broadcast_overwrite> ring(8);
+		auto& slow = ring.add_consumer();
+		std::vector<int> seen;
+
+		for(int i = 0; i < 20; ++i) {
+			ring.push(i);
+		}
+
+		while(slow.try_read([&](int val) { seen.push_back(val); })) {
+		}
+
+		assert((slow.lost() > 0 && slow.lost() + static_cast<long>(seen.size()) == 20) && "lapped values should be counted as lost");
+		assert((seen.back() == 19) && "should catch up to the latest");
+		for(std::size_t i = 1; i < seen.size(); ++i) {
+			assert((seen[i] == seen[i - 1] + 1) && "values after catching up should be in order");
+		}
+	}
+	{
+		// threads, overwriting: a slow consumer copies slots while they're
+		// overwritten, so must never see a torn value
+		const long count = 200000;
+		broadcast_ring<sample, broadcast_overwrite> ring(8);
+		auto& slow = ring.add_consumer();
+
+		bool torn = false, order_ok = true;
+		long seen = 0, last = -1;
+
+		std::thread tc([&] {
+			while(last < count - 1) {
+				seen += static_cast<long>(slow.read_batch([&](const sample& val) {
+					if(val.a != val.b || val.a != val.c || val.a != val.d) {
+						torn = true;
+					}
+					if(val.a <= last) {
+						order_ok = false;
+					}
+					last = val.a;
+				}, 4));
+			}
+		});
+
+		for(long i = 0; i < count; ++i) {
+			ring.push(sample{ i, i, i, i });
+		}
+		tc.join();
+
+		assert((!torn) && "values should never be torn");
+		assert((order_ok) && "values should be in order");
+		assert((seen + slow.lost() == count) && "every value is either seen or lost");
+	}
+	{
+		// threads: a journaller, then a processor depending on it
+		const int count = 100000;
+		broadcast_ring<long> ring(64);
+		auto& journal = ring.add_consumer();
+		auto& process = ring.add_consumer({ &journal });
+		auto& stats = ring.add_consumer();
+
+		long sum_journal = 0, sum_process = 0, sum_stats = 0;
+		bool order_ok = true;
+
+		std::thread tj([&] {
+			long n = 0;
+			while(n < count) {
+				n += static_cast<long>(journal.read_batch([&](long val) { sum_journal += val; }, 16));
+			}
+		});
+		std::thread tp([&] {
+			long n = 0;
+			while(n < count) {
+				n += static_cast<long>(process.read_batch([&](long val) {
+					sum_process += val;
+					if(journal.sequence() <= val) {
+						order_ok = false;
+					}
+				}, 16));
+			}
+		});
+		std::thread ts([&] {
+			long n = 0;
+			while(n < count) {
+				n += static_cast<long>(stats.read_batch([&](long val) { sum_stats += val; }, 16));
+			}
+		});
+
+		for(long i = 0; i < count; ++i) {
+			ring.push(i);
+		}
+		tj.join();
+		tp.join();
+		ts.join();
+
+		long expected = static_cast<long>(count) * (count - 1) / 2;
+		assert((sum_journal == expected && sum_process == expected && sum_stats == expected) && "every consumer sees every value");
+		assert((order_ok) && "processor should only see journalled values");
+	}
+}
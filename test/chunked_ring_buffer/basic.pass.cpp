@@ -0,0 +1,97 @@
+#include "include/chunked_ring_buffer.hpp"
+
+/*
+ * check pushing and popping at both ends, and random access, against a deque
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+
+#include "../pitfalls.hpp"
+
+int main()
+{
+	{
+		using C = chunked_ring_buffer<int, 4>;
+		C c;
+		std::deque<int> d;
+
+		// mix of operations, crossing chunk boundaries many times
+		for(int i = 0; i < 200; ++i) {
+			switch(i % 7) {
+			case 0: case 3:
+				c.push_back(i);
+				d.push_back(i);
+				break;
+			case 1: case 4: case 5:
+				c.push_front(i);
+				d.push_front(i);
+				break;
+			case 2:
+				c.pop_back();
+				d.pop_back();
+				break;
+			case 6:
+				c.pop_front();
+				d.pop_front();
+				break;
+			}
+
+			assert((c.size() == d.size()) && "size should match");
+			assert((std::equal(d.begin(), d.end(), c.begin())) && "values should match");
+			assert((c.chunk_count() <= c.size() / 4 + 2) && "should only hold chunks with values");
+		}
+
+		for(std::size_t i = 0; i < d.size(); ++i) {
+			assert((c[i] == d[i] && c.at(i) == d[i]) && "random access");
+		}
+		assert((std::equal(d.rbegin(), d.rend(), c.rbegin())) && "reverse iteration");
+		assert((c.end() - c.begin() == static_cast<std::ptrdiff_t>(c.size())) && "iterator distance");
+	}
+	{
+		using C = chunked_ring_buffer<int, 3>;
+		C c;
+
+		for(int i = 0; i < 10; ++i) {
+			c.push_back(i);
+		}
+		for(int i = 0; i < 10; ++i) {
+			c.pop_front();
+		}
+
+		assert((c.empty() && c.chunk_count() == 0) && "popping all should release all chunks");
+
+		c.push_front(5);
+
+		assert((c.size() == 1 && c.front() == 5 && c.back() == 5) && "push_front into empty");
+	}
+	{
+		using C = chunked_ring_buffer<int, 4>;
+		C c;
+		for(int i = 0; i < 10; ++i) {
+			c.push_back(i);
+		}
+
+		C d(c);
+		C e(std::move(c));
+		c = d;
+
+		assert((std::equal(d.begin(), d.end(), e.begin()) && e.size() == 10) && "copy and move");
+		assert((std::equal(d.begin(), d.end(), c.begin()) && c.size() == 10) && "assign");
+	}
+	{
+		using C = chunked_ring_buffer<pitfall, 2>;
+		C c;
+		for(int i = 0; i < 9; ++i) {
+			c.emplace_back();
+			c.emplace_front();
+		}
+		c.pop_front();
+		c.pop_back();
+
+		for(const auto& p : c) {
+			p.check();
+		}
+	}
+}
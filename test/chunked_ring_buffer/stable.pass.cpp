@@ -0,0 +1,54 @@
+#include "include/chunked_ring_buffer.hpp"
+
+/*
+ * check that growing never moves existing values
+ */
+
+#include <cassert>
+#include <vector>
+
+#include "../pitfalls.hpp"
+
+int main()
+{
+	{
+		using C = chunked_ring_buffer<int, 8>;
+		C c;
+		c.push_back(0);
+		std::vector<int*> addrs{ &c.front() };
+
+		for(int i = 1; i < 500; ++i) {
+			addrs.push_back(&c.push_back(i));
+			addrs.insert(addrs.begin(), &c.push_front(-i));
+		}
+
+		for(std::size_t i = 0; i < addrs.size(); ++i) {
+			assert((addrs[i] == &c[i]) && "values should not move on growth");
+		}
+
+		for(int i = 0; i < 100; ++i) {
+			c.pop_front();
+			c.pop_back();
+		}
+
+		for(std::size_t i = 0; i < c.size(); ++i) {
+			assert((addrs[i + 100] == &c[i]) && "values should not move on pop");
+		}
+	}
+	{
+		using C = chunked_ring_buffer<counted, 4>;
+		C c;
+		for(int i = 0; i < 10; ++i) {
+			c.emplace_back(i);
+		}
+		counted::reset();
+
+		for(int i = 0; i < 100; ++i) {
+			c.emplace_back(i);
+			c.emplace_front(i);
+		}
+
+		counted::counts expected = { 200, 0, 0, 0, 0, 0 };
+		assert((counted::count == expected) && "growth should not copy or move values");
+	}
+}
@@ -0,0 +1,147 @@
+#include "include/chunked_ring_buffer.hpp"
+
+/*
+ * check that a throwing constructor, or the map failing to grow, leaves no
+ * chunk behind
+ */
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace {
+
+// chunks and map blocks not yet freed
+long outstanding = 0;
+// make the map fail to grow
+bool fail_map = false;
+
+template <typename T>
+struct counting_alloc
+{
+	using value_type = T;
+
+	counting_alloc() = default;
+
+	template <typename U>
+	counting_alloc(const counting_alloc<U>&)
+	{
+	}
+
+	T* allocate(std::size_t n)
+	{
+		if(fail_map && std::is_pointer<T>::value) {
+			throw std::bad_alloc();
+		}
+		++outstanding;
+		return std::allocator<T>().allocate(n);
+	}
+
+	void deallocate(T* p, std::size_t n)
+	{
+		--outstanding;
+		std::allocator<T>().deallocate(p, n);
+	}
+};
+
+template <typename T, typename U>
+bool operator==(const counting_alloc<T>&, const counting_alloc<U>&)
+{
+	return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const counting_alloc<T>&, const counting_alloc<U>&)
+{
+	return false;
+}
+
+// throws from its constructor while fail is set
+struct fragile
+{
+	static bool fail;
+
+	int val;
+
+	explicit fragile(int v)
+		: val(v)
+	{
+		if(fail) {
+			throw v;
+		}
+	}
+};
+
+bool fragile::fail = false;
+
+} // namespace
+
+int main()
+{
+	using C = chunked_ring_buffer<fragile, 4, counting_alloc<fragile>>;
+	{
+		C c;
+
+		fragile::fail = true;
+		bool threw = false;
+		try {
+			c.emplace_back(1);
+		} catch(int) {
+			threw = true;
+		}
+		assert((threw && c.empty()) && "emplace_back into a new chunk should throw");
+
+		threw = false;
+		try {
+			c.emplace_front(2);
+		} catch(int) {
+			threw = true;
+		}
+		assert((threw && c.empty()) && "emplace_front into a new chunk should throw");
+		fragile::fail = false;
+	}
+	assert((outstanding == 0) && "a failed push should not leave a chunk in the map");
+	{
+		C c;
+		c.emplace_back(1);
+		c.emplace_back(2);
+		c.emplace_back(3);
+		c.emplace_back(4);
+
+		fragile::fail = true;
+		bool threw = false;
+		try {
+			c.emplace_back(5);
+		} catch(int) {
+			threw = true;
+		}
+		fragile::fail = false;
+		assert((threw && c.size() == 4) && "emplace_back into a new chunk should throw");
+
+		c.emplace_back(6);
+		c.emplace_front(0);
+		assert((c.size() == 6 && c.front().val == 0 && c.back().val == 6 && c[4].val == 4) && "pushing should work after a throw");
+	}
+	assert((outstanding == 0) && "every chunk should be freed");
+	{
+		C c;
+		c.emplace_back(0);
+
+		// push until a new chunk needs the map to grow
+		fail_map = true;
+		int pushed = 1;
+		try {
+			for(; pushed < 1000; ++pushed) {
+				c.emplace_back(pushed);
+			}
+		} catch(const std::bad_alloc&) {
+		}
+		fail_map = false;
+
+		assert((pushed < 1000 && c.size() == static_cast<std::size_t>(pushed)) && "map growth should fail");
+		assert((c.back().val == pushed - 1) && "a failed push should leave the values alone");
+	}
+	assert((outstanding == 0) && "a failed map growth should not leak the chunk");
+}
@@ -0,0 +1,151 @@
+#include "include/concurrent_ring_buffer.hpp"
+
+/*
+ * check fifo order and batching across growth and wrapping, several
+ * producers and consumers moving values at once, and watermark callbacks
+ * ending in step with the count under contention
+ */
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main()
+{
+	{
+		concurrent_ring_buffer<std::string> ring(2);
+		std::string out;
+
+		assert((ring.empty() && !ring.try_pop(out)) && "should start empty");
+
+		ring.push("a");
+		ring.push("b");
+		assert((ring.try_pop(out) && out == "a") && "pop oldest first");
+
+		// wraps, then grows while wrapped
+		std::vector<std::string> batch = { "c", "d", "e", "f" };
+		ring.push_many(batch.begin(), batch.end());
+		assert((ring.size() == 5 && ring.capacity() >= 5) && "push_many should grow as needed");
+
+		std::vector<std::string> popped;
+		assert((ring.pop_many(std::back_inserter(popped), 3) == 3) && "pop_many should stop at max");
+		assert((ring.pop_many(std::back_inserter(popped), 10) == 2) && "pop_many should stop when empty");
+		assert((popped == std::vector<std::string>{ "b", "c", "d", "e", "f" }) && "batches should keep fifo order");
+		assert((ring.empty()) && "should be empty");
+	}
+	{
+		const int producers = 3;
+		const int consumers = 2;
+		const int per_producer = 20000;
+
+		concurrent_ring_buffer<int> ring;
+		std::atomic<int> popped(0);
+		std::atomic<long> sum(0);
+
+		std::vector<std::thread> pool;
+		for(int p = 0; p < producers; ++p) {
+			pool.emplace_back([&, p] {
+				int batch[16];
+				for(int i = 0; i < per_producer; i += 16) {
+					for(int j = 0; j < 16; ++j) {
+						batch[j] = p * per_producer + i + j;
+					}
+					ring.push_many(batch, batch + 16);
+				}
+			});
+		}
+		for(int c = 0; c < consumers; ++c) {
+			pool.emplace_back([&] {
+				// per producer, values must come out increasing
+				std::vector<int> last(producers, -1);
+				int batch[8];
+				while(popped.load() < producers * per_producer) {
+					auto count = ring.pop_many(batch, 8);
+					for(std::size_t j = 0; j < count; ++j) {
+						auto p = static_cast<std::size_t>(batch[j] / per_producer);
+						assert((batch[j] > last[p]) && "each producer's values should stay in order");
+						last[p] = batch[j];
+						sum += batch[j];
+					}
+					popped += static_cast<int>(count);
+					if(count == 0) {
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+		for(auto& th : pool) {
+			th.join();
+		}
+
+		long n = producers * per_producer;
+		assert((sum.load() == n * (n - 1) / 2) && "every value should be popped exactly once");
+		assert((ring.empty()) && "should end empty");
+	}
+	{
+		// backpressure: producers pause between on_high and on_low, and
+		// the last callback must match the final count
+		using ring_type = concurrent_ring_buffer<int, std::allocator<int>, ring_buffer_watermark>;
+		const int producers = 3;
+		const int per_producer = 5000;
+
+		ring_type ring;
+		std::atomic<bool> paused(false);
+		std::atomic<bool> stuck(false);
+		std::atomic<int> highs(0);
+		ring.watermark().high = 64;
+		ring.watermark().low = 8;
+		ring.watermark().on_high = [&] {
+			// slow, so consumers would drain past low meanwhile, were the
+			// callbacks not ordered
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+			paused = true;
+			++highs;
+		};
+		ring.watermark().on_low = [&] { paused = false; };
+
+		std::atomic<int> pushed(0);
+		std::vector<std::thread> pool;
+		for(int p = 0; p < producers; ++p) {
+			pool.emplace_back([&] {
+				for(int i = 0; i < per_producer; ++i) {
+					auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+					while(paused.load() && !stuck.load()) {
+						if(std::chrono::steady_clock::now() > deadline) {
+							stuck = true;
+						}
+						std::this_thread::yield();
+					}
+					ring.push(i);
+					++pushed;
+				}
+			});
+		}
+		for(int c = 0; c < 2; ++c) {
+			pool.emplace_back([&] {
+				int batch[4];
+				while(pushed.load() < producers * per_producer || !ring.empty()) {
+					if(ring.pop_many(batch, 4) == 0) {
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+		for(auto& th : pool) {
+			th.join();
+		}
+
+		assert((!stuck.load()) && "producers should never be left paused");
+		assert((highs.load() > 0) && "producers should have been paused");
+		assert((ring.empty() && !paused.load()) && "a drained ring should end unpaused");
+
+		for(int i = 0; i < 64; ++i) {
+			ring.push(i);
+		}
+		assert((paused.load()) && "a ring at high should end paused");
+	}
+}
@@ -0,0 +1,182 @@
+#include "include/delta_ring.hpp"
+
+/*
+ * check that values round trip through every way of reading, including
+ * large and wrapping deltas, that dropping front blocks keeps the rest, and
+ * that a slowly varying series takes a fraction of ring_buffer<int64_t>, and
+ * that a push which fails to allocate leaves the size alone
+ */
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace {
+
+// throws from allocate while fail is set
+bool fail = false;
+
+template <typename T>
+struct failing_alloc
+{
+	using value_type = T;
+
+	failing_alloc() = default;
+
+	template <typename U>
+	failing_alloc(const failing_alloc<U>&)
+	{
+	}
+
+	T* allocate(std::size_t n)
+	{
+		if(fail) {
+			throw std::bad_alloc();
+		}
+		return std::allocator<T>().allocate(n);
+	}
+
+	void deallocate(T* p, std::size_t n)
+	{
+		std::allocator<T>().deallocate(p, n);
+	}
+};
+
+template <typename T, typename U>
+bool operator==(const failing_alloc<T>&, const failing_alloc<U>&)
+{
+	return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const failing_alloc<T>&, const failing_alloc<U>&)
+{
+	return false;
+}
+
+} // namespace
+
+template <typename R, typename Int>
+bool same(const R& ring, const std::vector<Int>& expected)
+{
+	if(ring.size() != expected.size()) {
+		return false;
+	}
+
+	std::size_t i = 0;
+	for(auto val : ring) {
+		if(i >= expected.size() || val != expected[i++]) {
+			return false;
+		}
+	}
+
+	std::vector<Int> seen;
+	ring.for_each([&](Int val) { seen.push_back(val); });
+	return i == expected.size() && seen == expected;
+}
+
+int main()
+{
+	{
+		delta_ring<> ring;
+		assert((ring.empty() && ring.begin() == ring.end() && ring.block_count() == 0) && "should start empty");
+		assert((ring.pop_front_block() == 0) && "nothing to drop");
+
+		using lim = std::numeric_limits<std::int64_t>;
+		std::vector<std::int64_t> values = { 5, 5, 6, 4, -100, 1000000, lim::max(), lim::min(), 0, lim::min(), lim::max(), -1 };
+		for(auto val : values) {
+			ring.push_back(val);
+		}
+		assert((same(ring, values)) && "extreme deltas should round trip");
+		assert((ring.front() == 5 && ring.back() == -1) && "front and back are the ends");
+	}
+	{
+		delta_ring<std::int64_t, 64> ring;
+		std::vector<std::int64_t> values;
+		std::int64_t val = 1700000000;
+		for(int i = 0; i < 1000; ++i) {
+			val += (i % 7) - 3 + (i % 50 == 0 ? 100000 : 0);
+			values.push_back(val);
+			ring.push_back(val);
+		}
+		assert((same(ring, values) && ring.block_count() > 1) && "should round trip across blocks");
+
+		std::vector<std::int64_t> buf(delta_ring<std::int64_t, 64>::max_block_values);
+		std::size_t total = 0;
+		for(std::size_t b = 0; b < ring.block_count(); ++b) {
+			auto n = ring.decode_block(b, buf.data());
+			assert((n == ring.block_size(b) && n <= buf.size()) && "decode_block should give the block's values");
+			for(std::size_t i = 0; i < n; ++i) {
+				assert((buf[i] == values[total + i]) && "decode_block should decode in order");
+			}
+			total += n;
+		}
+		assert((total == values.size()) && "blocks should cover every value");
+
+		// retention: drop whole blocks from the front
+		while(ring.size() > 500) {
+			auto first = ring.block_size(0);
+			assert((ring.pop_front_block() == first) && "should drop the front block's values");
+			values.erase(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(first));
+		}
+		assert((same(ring, values) && ring.front() == values.front()) && "the rest should be kept");
+
+		for(int i = 0; i < 100; ++i) {
+			ring.push_back(i);
+			values.push_back(i);
+		}
+		assert((same(ring, values)) && "should append after dropping");
+
+		ring.clear();
+		assert((ring.empty() && ring.block_count() == 0 && ring.begin() == ring.end()) && "clear should drop everything");
+	}
+	{
+		// unsigned and narrow types wrap
+		delta_ring<std::uint8_t, 16> ring;
+		std::vector<std::uint8_t> values;
+		for(int i = 0; i < 600; ++i) {
+			values.push_back(static_cast<std::uint8_t>(i * 37));
+			ring.push_back(values.back());
+		}
+		assert((same(ring, values)) && "narrow unsigned values should round trip");
+	}
+	{
+		// per second timestamps and a slowly varying gauge
+		const std::size_t count = 100000;
+		delta_ring<> times;
+		delta_ring<> gauge;
+		std::int64_t level = 5000;
+		for(std::size_t i = 0; i < count; ++i) {
+			times.push_back(static_cast<std::int64_t>(1700000000 + i));
+			level += static_cast<std::int64_t>(i * 2654435761u % 41) - 20;
+			gauge.push_back(level);
+		}
+		times.shrink_to_fit();
+		gauge.shrink_to_fit();
+
+		auto plain = count * sizeof(std::int64_t);
+		assert((times.memory_bytes() * 6 < plain) && "constant deltas should take about a byte each");
+		assert((gauge.memory_bytes() * 4 < plain) && "small deltas should take about a byte each");
+	}
+	{
+		delta_ring<std::int64_t, 64, failing_alloc<std::int64_t>> ring;
+
+		// the first value needs a block, and so a memblk
+		fail = true;
+		bool threw = false;
+		try {
+			ring.push_back(1);
+		} catch(const std::bad_alloc&) {
+			threw = true;
+		}
+		fail = false;
+
+		assert((threw && ring.empty() && ring.size() == 0) && "a push which throws should leave the size alone");
+		ring.push_back(1);
+		ring.push_back(2);
+		assert((same(ring, std::vector<std::int64_t>{ 1, 2 })) && "pushing should work after a throw");
+	}
+}
@@ -0,0 +1,85 @@
+#include "include/double_ring.hpp"
+
+/*
+ * check that swapping out hands over everything pushed so far in order,
+ * that the rings are reused without reallocating, and producers pushing
+ * while the consumer swaps
+ */
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main()
+{
+	{
+		double_ring<std::string> dr(8);
+
+		dr.push("a");
+		dr.emplace(2, 'b');
+		std::vector<std::string> more = { "c", "d" };
+		dr.push_many(more.begin(), more.end());
+
+		auto& batch = dr.swap_out();
+		assert((batch.size() == 4 && batch.front() == "a" && batch[1] == "bb" && batch.back() == "d") && "batch should hold everything, in order");
+
+		dr.push("e");
+		std::string seen;
+		assert((dr.drain([&](std::string& val) { seen += val; }) == 1 && seen == "e") && "drain should only see values since the last swap");
+		assert((dr.swap_out().empty()) && "nothing pushed since");
+	}
+	{
+		// both rings keep their memblks once grown
+		double_ring<int> dr;
+		const int* first_data[2] = { nullptr, nullptr };
+		for(int frame = 0; frame < 6; ++frame) {
+			for(int i = 0; i < 100; ++i) {
+				dr.push(i);
+			}
+			auto& batch = dr.swap_out();
+			auto data = batch.first_segment().first;
+			if(frame < 2) {
+				first_data[frame] = data;
+			} else {
+				assert((data == first_data[frame % 2]) && "rings should be reused without reallocating");
+			}
+		}
+	}
+	{
+		const int producers = 3;
+		const int per_producer = 20000;
+		double_ring<int> dr;
+		std::atomic<int> done(0);
+
+		std::vector<std::thread> pool;
+		for(int p = 0; p < producers; ++p) {
+			pool.emplace_back([&, p] {
+				for(int i = 0; i < per_producer; ++i) {
+					dr.push(p * per_producer + i);
+				}
+				++done;
+			});
+		}
+
+		std::vector<int> last(producers, -1);
+		long count = 0;
+		auto check = [&](int& val) {
+			auto p = static_cast<std::size_t>(val / per_producer);
+			assert((val > last[p]) && "each producer's values should stay in order");
+			last[p] = val;
+			++count;
+		};
+		while(done.load() < producers) {
+			dr.drain(check);
+		}
+		for(auto& th : pool) {
+			th.join();
+		}
+		dr.drain(check);
+
+		assert((count == producers * per_producer) && "every value should be handed over once");
+	}
+}
@@ -0,0 +1,77 @@
+#include "include/elastic_spsc_ring.hpp"
+
+/*
+ * check growing past the first segment, that drained segments are
+ * recycled, that values left in the queue are destroyed, and a producer and
+ * consumer thread handing over values in order while segments are linked
+ */
+
+#include <cassert>
+#include <memory>
+#include <string>
+#include <thread>
+
+int main()
+{
+	{
+		elastic_spsc_ring<std::string> q(2, 8);
+		std::string out;
+
+		assert((q.empty() && !q.try_pop(out)) && "should start empty");
+
+		for(int i = 0; i < 30; ++i) {
+			q.push(std::to_string(i));
+		}
+		// 2 + 4 + 8 + 8 + 8 holds 30
+		assert((q.segment_count() == 5) && "segments should double up to the maximum");
+
+		for(int i = 0; i < 30; ++i) {
+			assert((q.try_pop(out) && out == std::to_string(i)) && "values should come out in order across segments");
+		}
+		assert((q.empty() && !q.try_pop(out)) && "should be empty after popping everything");
+		assert((q.segment_count() == 1) && "drained segments should be released");
+
+		// pushing more reuses the spare
+		for(int i = 0; i < 20; ++i) {
+			q.push("x");
+		}
+		for(int i = 0; i < 20; ++i) {
+			assert((q.try_pop(out) && out == "x") && "values after recycling");
+		}
+	}
+	{
+		// values still in the queue are destroyed with it
+		auto counted = std::make_shared<int>(0);
+		{
+			elastic_spsc_ring<std::shared_ptr<int>> q(2);
+			for(int i = 0; i < 5; ++i) {
+				q.push(counted);
+			}
+			assert((counted.use_count() == 6) && "queue should hold copies");
+		}
+		assert((counted.use_count() == 1) && "destroying the queue should destroy its values");
+	}
+	{
+		const long total = 200000;
+		elastic_spsc_ring<long> q(4, 256);
+
+		std::thread producer([&] {
+			for(long i = 0; i < total; ++i) {
+				q.push(i);
+			}
+		});
+
+		long expected = 0;
+		while(expected < total) {
+			long val;
+			if(q.try_pop(val)) {
+				assert((val == expected) && "values should arrive in push order");
+				++expected;
+			} else {
+				std::this_thread::yield();
+			}
+		}
+		producer.join();
+		assert((q.empty()) && "everything should be consumed");
+	}
+}
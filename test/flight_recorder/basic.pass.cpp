@@ -0,0 +1,136 @@
+#include "include/flight_recorder.hpp"
+
+/*
+ * check that dumps hold each live thread's latest events, oldest first, and
+ * that the crash handler dumps on abort
+ */
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+struct thread_events
+{
+	std::uint64_t thread;
+	std::vector<flight_event> events;
+};
+
+// read a dump back from the start of fd
+std::vector<thread_events> parse(int fd)
+{
+	std::vector<char> bytes;
+	char buf[4096];
+	::lseek(fd, 0, SEEK_SET);
+	ssize_t got;
+	while((got = ::read(fd, buf, sizeof(buf))) > 0) {
+		bytes.insert(bytes.end(), buf, buf + got);
+	}
+
+	flight_recorder_detail::file_header file;
+	assert((bytes.size() >= sizeof(file)) && "dump should have a file header");
+	std::memcpy(&file, bytes.data(), sizeof(file));
+	assert((std::memcmp(file.magic, "FLRC", 4) == 0 && file.event_size == sizeof(flight_event)) && "file header");
+
+	std::vector<thread_events> out;
+	std::size_t pos = sizeof(file);
+	while(pos < bytes.size()) {
+		flight_recorder_detail::thread_header hdr;
+		std::memcpy(&hdr, bytes.data() + pos, sizeof(hdr));
+		pos += sizeof(hdr);
+
+		thread_events te;
+		te.thread = hdr.thread;
+		te.events.resize(hdr.count);
+		assert((pos + hdr.count * sizeof(flight_event) <= bytes.size()) && "events should not be cut short");
+		std::memcpy(te.events.data(), bytes.data() + pos, hdr.count * sizeof(flight_event));
+		pos += hdr.count * sizeof(flight_event);
+		out.push_back(te);
+	}
+	return out;
+}
+
+} // namespace
+
+int main()
+{
+	flight_recorder::set_capacity(8);
+
+	{
+		std::FILE* file = std::tmpfile();
+		int fd = fileno(file);
+
+		std::atomic<bool> recorded(false), dumped(false);
+		std::thread other([&] {
+			for(std::uint32_t i = 0; i < 3; ++i) {
+				flight_recorder::record(2, i);
+			}
+			recorded = true;
+			// stay alive, so the ring is still listed
+			while(!dumped) {
+				std::this_thread::yield();
+			}
+		});
+
+		// wraps the ring
+		for(std::uint32_t i = 0; i < 20; ++i) {
+			flight_recorder::record(1, i, i * 10);
+		}
+		while(!recorded) {
+			std::this_thread::yield();
+		}
+
+		assert((flight_recorder::dump(fd)) && "dump should succeed");
+		dumped = true;
+		other.join();
+
+		auto threads = parse(fd);
+		assert((threads.size() == 2) && "both threads should be dumped");
+		for(auto& te : threads) {
+			if(te.events[0].id == 1) {
+				assert((te.events.size() == 8) && "only the latest capacity events are kept");
+				for(std::uint32_t i = 0; i < 8; ++i) {
+					assert((te.events[i].arg == 12 + i && te.events[i].data == (12 + i) * 10) && "oldest first, across the wrap");
+					assert((i == 0 || te.events[i].time >= te.events[i - 1].time) && "times should increase");
+				}
+			} else {
+				assert((te.events.size() == 3 && te.events[2].arg == 2) && "other thread's events");
+			}
+		}
+		std::fclose(file);
+	}
+	{
+		std::FILE* file = std::tmpfile();
+		int fd = fileno(file);
+
+		auto pid = ::fork();
+		if(pid == 0) {
+			flight_recorder::install_crash_handler(fd);
+			flight_recorder::record(7, 1);
+			flight_recorder::record(7, 2);
+			std::abort();
+		}
+
+		int status = 0;
+		::waitpid(pid, &status, 0);
+		assert((WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT) && "child should still die of the signal");
+
+		auto threads = parse(fd);
+		bool found = false;
+		for(auto& te : threads) {
+			if(!te.events.empty() && te.events.back().id == 7) {
+				found = te.events.back().arg == 2;
+			}
+		}
+		assert((found) && "crash dump should hold the child's events");
+		std::fclose(file);
+	}
+}
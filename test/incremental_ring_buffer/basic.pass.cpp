@@ -0,0 +1,130 @@
+#include "include/incremental_ring_buffer.hpp"
+
+/*
+ * check values stay in order and accessible while migrating between memblks
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <string>
+
+#include "../pitfalls.hpp"
+
+int main()
+{
+	{
+		using C = incremental_ring_buffer<int>;
+		C c;
+		std::deque<int> d;
+		bool saw_migration = false;
+
+		for(int i = 0; i < 2000; ++i) {
+			switch(i % 9) {
+			case 0: case 2: case 3: case 5: case 7:
+				c.push_back(i);
+				d.push_back(i);
+				break;
+			case 1: case 6:
+				c.push_front(i);
+				d.push_front(i);
+				break;
+			case 4:
+				c.pop_front();
+				d.pop_front();
+				break;
+			case 8:
+				c.pop_back();
+				d.pop_back();
+				break;
+			}
+
+			saw_migration = saw_migration || c.migrating();
+
+			assert((c.size() == d.size()) && "size should match");
+			assert((c.front() == d.front() && c.back() == d.back()) && "ends should match");
+		}
+
+		assert((saw_migration) && "growth should migrate incrementally");
+		assert((std::equal(d.begin(), d.end(), c.begin())) && "values should match");
+		for(std::size_t i = 0; i < d.size(); ++i) {
+			assert((c[i] == d[i] && c.at(i) == d[i]) && "random access");
+		}
+
+		c.finish_migration();
+
+		assert((!c.migrating() && std::equal(d.rbegin(), d.rend(), c.rbegin())) && "finish_migration");
+	}
+	{
+		using C = incremental_ring_buffer<int>;
+		C c;
+		std::deque<int> d;
+
+		// only pushing to the front, so m_old fills up while migrating
+		for(int i = 0; i < 1000; ++i) {
+			c.push_front(i);
+			d.push_front(i);
+		}
+
+		assert((c.size() == d.size() && std::equal(d.begin(), d.end(), c.begin())) && "push_front only");
+
+		while(!c.empty()) {
+			assert((c.back() == d.back()) && "pop_back while migrating");
+			c.pop_back();
+			d.pop_back();
+		}
+	}
+	{
+		using C = incremental_ring_buffer<pitfall>;
+		C c;
+		for(int i = 0; i < 300; ++i) {
+			c.emplace_back();
+			if(i % 3 == 0) {
+				c.emplace_front();
+			}
+		}
+
+		for(const auto& p : c) {
+			p.check();
+		}
+	}
+	{
+		// pushing the ring's own values, while migrating moves them
+		using C = incremental_ring_buffer<std::string>;
+		C c;
+		std::deque<std::string> d;
+		bool saw_migration = false;
+
+		for(int i = 0; i < 400; ++i) {
+			// longer than any small string buffer, so moving empties them
+			auto val = std::string(20, 'x') + std::to_string(i);
+			switch(i % 5) {
+			case 0:
+				c.push_back(val);
+				d.push_back(val);
+				break;
+			case 1:
+				c.push_back(c.front());
+				d.push_back(d.front());
+				break;
+			case 2:
+				c.push_back(c.back());
+				d.push_back(d.back());
+				break;
+			case 3:
+				c.push_front(c.back());
+				d.push_front(d.back());
+				break;
+			case 4:
+				c.push_front(c.front());
+				d.push_front(d.front());
+				break;
+			}
+
+			saw_migration = saw_migration || c.migrating();
+			assert((c.size() == d.size() && std::equal(d.begin(), d.end(), c.begin())) && "pushing own values should copy them first");
+		}
+
+		assert((saw_migration) && "should push own values while migrating");
+	}
+}
@@ -0,0 +1,77 @@
+#include "include/incremental_ring_buffer.hpp"
+
+/*
+ * check that compilation produces no warnings
+ * preferrably, use -Weverything -Wno-c++98-compat
+ */
+
+#include <memory>
+
+#include "../unused.hpp"
+
+template <typename T>
+void test()
+{
+	using C = incremental_ring_buffer<T>;
+	T val = T();
+
+	C a, b;
+	const auto& ca = a;
+
+	a.get_allocator();
+
+	a.push_back(val);
+	a.push_back(std::move(val));
+	a.emplace_back();
+	a.push_front(val);
+	a.push_front(std::move(val));
+	a.emplace_front();
+
+	a.at(0);
+	ca.at(0);
+	a[0];
+	ca[0];
+	a.front();
+	ca.front();
+	a.back();
+	ca.back();
+
+	a.begin();
+	ca.begin();
+	ca.cbegin();
+	a.end();
+	ca.end();
+	ca.cend();
+	a.rbegin();
+	ca.rbegin();
+	a.rend();
+	ca.rend();
+
+	typename C::const_iterator it = a.begin();
+	unused(it);
+
+	a.empty();
+	a.size();
+	a.capacity();
+	a.migrating();
+
+	a.pop_front();
+	a.pop_back();
+	a.finish_migration();
+	a.clear();
+	a.swap(b);
+	swap(a, b);
+}
+
+void check();
+
+void check()
+{
+	// don't actually call it
+	// but still instantiate the function
+	test<int>();
+}
+
+int main()
+{
+}
@@ -12,9 +12,14 @@
  *  3. comma operator (could be overloaded)
  *  3. raw copying (bypassing the copy constructors and such)
  *  4. skipped destructors (freeing memory without destroying the contained objects)
+ *
+ * A second class, counted, extends pitfall to also count the constructors,
+ * assignments and destructors called, so that tests can check a container
+ * does not make needless copies or moves.
  */
 
 #include <cassert>
+#include <memory>
 
 class pitfall
 {
@@ -59,7 +64,7 @@ public: // methods
 	pitfall& operator=(const pitfall& other)
 	{
 		assert(self == this);
-		assert(other.self == &other);
+		assert(other.self == std::addressof(other));
 		return *this;
 	}
 
@@ -112,3 +117,95 @@ public: // methods
 };
 
 int pitfall::live_count = 0;
+
+class counted : public pitfall
+{
+public: // statics
+	struct counts
+	{
+		int ctor; // from value, or default
+		int copy_ctor;
+		int move_ctor;
+		int copy_assign;
+		int move_assign;
+		int dtor;
+
+		friend bool operator==(const counts& lhs, const counts& rhs)
+		{
+			return lhs.ctor == rhs.ctor
+				&& lhs.copy_ctor == rhs.copy_ctor
+				&& lhs.move_ctor == rhs.move_ctor
+				&& lhs.copy_assign == rhs.copy_assign
+				&& lhs.move_assign == rhs.move_assign
+				&& lhs.dtor == rhs.dtor;
+		}
+	};
+
+	// totals since the last reset
+	static counts count;
+
+	static void reset()
+	{
+		count = counts();
+	}
+private: // variables
+	int val;
+public: // methods
+	counted()
+		noexcept
+		: val(0)
+	{
+		++count.ctor;
+	}
+
+	explicit counted(int i_val)
+		noexcept
+		: val(i_val)
+	{
+		++count.ctor;
+	}
+
+	counted(const counted& other)
+		noexcept
+		: pitfall(other), val(other.val)
+	{
+		++count.copy_ctor;
+	}
+
+	counted(counted&& other)
+		noexcept
+		: pitfall(other), val(other.val)
+	{
+		++count.move_ctor;
+	}
+
+	~counted()
+	{
+		++count.dtor;
+	}
+
+	counted& operator=(const counted& other)
+	{
+		pitfall::operator=(other);
+		val = other.val;
+		++count.copy_assign;
+		return *this;
+	}
+
+	counted& operator=(counted&& other)
+		noexcept
+	{
+		pitfall::operator=(other);
+		val = other.val;
+		++count.move_assign;
+		return *this;
+	}
+
+	int value() const
+	{
+		return val;
+	}
+
+};
+
+counted::counts counted::count = counted::counts();
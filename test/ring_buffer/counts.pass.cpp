@@ -0,0 +1,266 @@
+#include "include/ring_buffer.hpp"
+
+/*
+ * check that operations make no more copies, moves, constructions and
+ * destructions than needed
+ */
+
+#include <cassert>
+#include <iterator>
+#include <utility>
+
+#include "../pitfalls.hpp"
+
+using C = ring_buffer<counted>;
+
+// ring with values 0 to size - 1, starting part way through the memblk
+C make(int size, int cap)
+{
+	C c(static_cast<C::size_type>(cap));
+	for(int i = 0; i < cap / 2; ++i) {
+		c.emplace_back();
+	}
+	c.pop_front_n(static_cast<C::size_type>(cap / 2));
+	for(int i = 0; i < size; ++i) {
+		c.emplace_back(i);
+	}
+
+	counted::reset();
+	return c;
+}
+
+bool counts_are(int ctor, int copy_ctor, int move_ctor, int copy_assign, int move_assign, int dtor)
+{
+	counted::counts expected = { ctor, copy_ctor, move_ctor, copy_assign, move_assign, dtor };
+	return counted::count == expected;
+}
+
+int main()
+{
+	// {{{ push and pop
+
+	{
+		auto c = make(4, 16);
+		counted x(9);
+		counted::reset();
+
+		c.push_back(x);
+		assert((counts_are(0, 1, 0, 0, 0, 0)) && "push_back lvalue should copy once");
+
+		counted::reset();
+		c.push_back(std::move(x));
+		assert((counts_are(0, 0, 1, 0, 0, 0)) && "push_back rvalue should move once");
+
+		counted::reset();
+		c.push_front(x);
+		assert((counts_are(0, 1, 0, 0, 0, 0)) && "push_front lvalue should copy once");
+
+		counted::reset();
+		c.push_front(std::move(x));
+		assert((counts_are(0, 0, 1, 0, 0, 0)) && "push_front rvalue should move once");
+
+		counted::reset();
+		c.emplace_back(1);
+		c.emplace_front(2);
+		assert((counts_are(2, 0, 0, 0, 0, 0)) && "emplace should construct in place");
+
+		counted::reset();
+		c.pop_back();
+		c.pop_front();
+		assert((counts_are(0, 0, 0, 0, 0, 2)) && "pop should only destroy");
+
+		counted::reset();
+		c.pop_front_n(2);
+		c.pop_back_n(2);
+		assert((counts_are(0, 0, 0, 0, 0, 4)) && "pop_*_n should only destroy");
+	}
+	{
+		auto c = make(8, 8);
+		counted x(9);
+		counted::reset();
+
+		c.push_back(std::move(x));
+
+		assert((counts_are(0, 0, 9, 0, 0, 8)) && "push_back rvalue with growth should only move");
+	}
+	{
+		auto c = make(8, 8);
+
+		c.emplace_front(9);
+
+		assert((counts_are(1, 0, 8, 0, 0, 8)) && "emplace_front with growth should only move old values");
+	}
+	{
+		auto c = make(8, 8);
+
+		c.push_back(c.front());
+
+		assert((counts_are(0, 1, 8, 0, 0, 8)) && "push_back own value with growth should copy once");
+		assert((c.back().value() == 0) && "push_back own value with growth should copy before moving");
+	}
+	{
+		// shrinks on the second op below a quarter full
+		using S = ring_buffer<counted, std::allocator<counted>, std::size_t, ring_buffer_shrink_hysteresis<1, 4, 2>>;
+		S c(16);
+		c.emplace_back(5);
+		counted::reset();
+
+		c.push_back(c.front());
+
+		assert((c.capacity() == 8) && "push_back should let the policy shrink");
+		assert((counts_are(0, 1, 2, 0, 0, 2)) && "push_back own value with shrinking should copy once");
+		assert((c.front().value() == 5 && c.back().value() == 5) && "push_back own value should copy before shrinking");
+	}
+
+	// }}}
+
+	// {{{ insert and erase
+
+	{
+		auto c = make(8, 16);
+		counted x(9);
+		counted::reset();
+
+		c.insert(std::next(c.cbegin(), 2), x);
+
+		assert((counts_are(0, 1, 1, 0, 1, 1)) && "insert near front should shift the front");
+	}
+	{
+		auto c = make(8, 16);
+		counted x(9);
+		counted::reset();
+
+		c.insert(std::next(c.cbegin(), 6), std::move(x));
+
+		assert((counts_are(0, 0, 2, 0, 1, 1)) && "insert rvalue near back should shift the back");
+	}
+	{
+		auto c = make(8, 16);
+		counted x(9);
+		counted::reset();
+
+		c.insert(std::next(c.cbegin()), 3, x);
+
+		assert((counts_are(0, 3, 1, 0, 0, 1)) && "fill insert should copy once per value");
+	}
+	{
+		auto c = make(8, 16);
+
+		c.insert(std::next(c.cbegin()), 3, c.back());
+
+		assert((counts_are(0, 3, 1, 0, 0, 1)) && "fill insert of own value should not copy it first");
+	}
+	{
+		auto c = make(8, 16);
+
+		c.erase(std::next(c.cbegin(), 2));
+
+		assert((counts_are(0, 0, 0, 0, 2, 1)) && "erase near front should shift the front");
+
+		counted::reset();
+		c.erase(std::next(c.cbegin(), 4), std::next(c.cbegin(), 6));
+
+		assert((counts_are(0, 0, 0, 0, 1, 2)) && "erase range near back should shift the back");
+	}
+	{
+		auto c = make(8, 16);
+
+		erase_if(c, [](const counted& x) { return x.value() % 2 == 0; });
+
+		assert((counts_are(0, 0, 0, 0, 4, 4)) && "erase_if should move each kept value at most once");
+	}
+
+	// }}}
+
+	// {{{ resize and assign
+
+	{
+		auto c = make(8, 16);
+
+		c.resize(11);
+		assert((counts_are(3, 0, 0, 0, 0, 0)) && "resize up should construct");
+
+		counted::reset();
+		c.resize(9);
+		assert((counts_are(0, 0, 0, 0, 0, 2)) && "resize down should destroy");
+
+		counted::reset();
+		c.resize(11, c.front());
+		assert((counts_are(0, 2, 0, 0, 0, 0)) && "resize with value should copy");
+
+		counted::reset();
+		c.resize_for_overwrite(13);
+		assert((counts_are(2, 0, 0, 0, 0, 0)) && "resize_for_overwrite of non-trivial should construct");
+	}
+	{
+		auto c = make(8, 16);
+		counted x(9);
+		counted::reset();
+
+		c.assign(5, x);
+		assert((counts_are(0, 0, 0, 5, 0, 3)) && "assign fewer should assign over values");
+
+		counted::reset();
+		c.assign(10, x);
+		assert((counts_are(0, 5, 0, 5, 0, 0)) && "assign more should assign over values");
+	}
+
+	// }}}
+
+	// {{{ capacity
+
+	{
+		auto c = make(8, 8);
+
+		c.reserve(20);
+		assert((counts_are(0, 0, 8, 0, 0, 8)) && "reserve should move");
+
+		counted::reset();
+		c.shrink_to_fit();
+		assert((counts_are(0, 0, 8, 0, 0, 8)) && "shrink_to_fit should move");
+
+		counted::reset();
+		c.clear();
+		assert((counts_are(0, 0, 0, 0, 0, 8)) && "clear should destroy");
+	}
+
+	// }}}
+
+	// {{{ ctors and assignment
+
+	{
+		auto c = make(8, 16);
+
+		C d(c);
+		assert((counts_are(0, 8, 0, 0, 0, 0)) && "copy ctor should copy");
+
+		counted::reset();
+		C e(std::move(d));
+		assert((counts_are(0, 0, 0, 0, 0, 0)) && "move ctor should not touch values");
+
+		counted::reset();
+		e = std::move(c);
+		assert((counts_are(0, 0, 0, 0, 0, 8)) && "move assign should only destroy old values");
+
+		counted::reset();
+		swap(c, e);
+		assert((counts_are(0, 0, 0, 0, 0, 0)) && "swap should not touch values");
+
+		auto f = make(3, 4);
+		f = c;
+		assert((counts_are(0, 8, 0, 0, 0, 3)) && "copy assign should copy");
+	}
+	{
+		counted vals[4];
+		counted::reset();
+
+		C c(std::begin(vals), std::end(vals));
+		assert((counts_are(0, 4, 0, 0, 0, 0)) && "range ctor should copy");
+
+		counted::reset();
+		C d(5, vals[0]);
+		assert((counts_are(0, 5, 0, 0, 0, 0)) && "count ctor should copy");
+	}
+
+	// }}}
+}
@@ -0,0 +1,87 @@
+#include "include/ring_buffer.hpp"
+
+/*
+ * check erase of single values and ranges, from either side and across the wrap
+ */
+
+#include <cassert>
+#include <deque>
+#include <iterator>
+
+#include "../pitfalls.hpp"
+
+// fill so that the values wrap around the end of the memblk
+template <typename C>
+void fill_wrapped(C& c, int count)
+{
+	c.reserve(static_cast<typename C::size_type>(count));
+	for(int i = 0; i < count / 2; ++i) {
+		c.push_back(i);
+	}
+	for(int i = 0; i < count / 2; ++i) {
+		c.pop_front();
+	}
+	for(int i = 0; i < count; ++i) {
+		c.push_back(i);
+	}
+}
+
+template <typename C>
+bool same(const C& c, const std::deque<int>& d)
+{
+	return c.size() == d.size() && std::equal(d.begin(), d.end(), c.begin());
+}
+
+int main()
+{
+	{
+		using C = ring_buffer<int>;
+		C c{ 1, 2, 3, 4, 5 };
+
+		auto it = c.erase(std::next(c.cbegin()));
+
+		assert((*it == 3) && "erase should return the value after the erased one");
+		assert((same(c, { 1, 3, 4, 5 })) && "erase near front");
+
+		it = c.erase(std::prev(c.cend(), 2));
+
+		assert((*it == 5) && "erase should return the value after the erased one");
+		assert((same(c, { 1, 3, 5 })) && "erase near back");
+
+		it = c.erase(std::prev(c.cend()));
+
+		assert((it == c.end()) && "erasing the last value returns end");
+		assert((same(c, { 1, 3 })) && "erase back");
+	}
+	for(int first = 0; first <= 12; ++first) {
+		for(int last = first; last <= 12; ++last) {
+			using C = ring_buffer<int>;
+			C c;
+			fill_wrapped(c, 12);
+			std::deque<int> d(c.begin(), c.end());
+
+			auto cap = c.capacity();
+			auto it = c.erase(std::next(c.cbegin(), first), std::next(c.cbegin(), last));
+			d.erase(d.begin() + first, d.begin() + last);
+
+			assert((same(c, d)) && "erase range across the wrap");
+			assert((std::distance(c.begin(), it) == first) && "erase should return the value after the range");
+			assert((c.capacity() == cap) && "erase should not reallocate");
+		}
+	}
+	{
+		using C = ring_buffer<pitfall>;
+		C c(10);
+		for(int i = 0; i < 8; ++i) {
+			c.emplace_back();
+		}
+
+		c.erase(std::next(c.cbegin()), std::next(c.cbegin(), 3));
+		c.erase(std::prev(c.cend(), 3), std::prev(c.cend()));
+
+		assert((c.size() == 4) && "erase should remove values");
+		for(const auto& p : c) {
+			p.check();
+		}
+	}
+}
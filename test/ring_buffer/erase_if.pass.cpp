@@ -0,0 +1,79 @@
+#include "include/ring_buffer.hpp"
+
+/*
+ * check erase_if compaction, including across the wrap
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <string>
+
+#include "../pitfalls.hpp"
+
+// start the values part way through the memblk, so they wrap around
+template <typename C, typename F>
+void fill_wrapped(C& c, int count, F make)
+{
+	c.reserve(static_cast<typename C::size_type>(count));
+	for(int i = 0; i < count / 2; ++i) {
+		c.push_back(make(i));
+	}
+	for(int i = 0; i < count / 2; ++i) {
+		c.pop_front();
+	}
+	for(int i = 0; i < count; ++i) {
+		c.push_back(make(i));
+	}
+}
+
+int main()
+{
+	{
+		using C = ring_buffer<int>;
+		C c;
+
+		auto n = erase_if(c, [](int) { return true; });
+
+		assert((n == 0 && c.empty()) && "erase_if on empty should do nothing");
+	}
+	for(int mod = 1; mod <= 4; ++mod) {
+		using C = ring_buffer<int>;
+		C c;
+		fill_wrapped(c, 15, [](int i) { return i; });
+		std::deque<int> d(c.begin(), c.end());
+
+		auto pred = [mod](int x) { return x % mod == 0; };
+		auto n = erase_if(c, pred);
+		auto old_size = d.size();
+		d.erase(std::remove_if(d.begin(), d.end(), pred), d.end());
+
+		assert((n == old_size - d.size()) && "erase_if should return the number removed");
+		assert((c.size() == d.size() && std::equal(d.begin(), d.end(), c.begin())) && "erase_if should keep order");
+	}
+	{
+		using C = ring_buffer<std::string>;
+		C c;
+		fill_wrapped(c, 11, [](int i) { return std::string(20, char('a' + i)); });
+
+		auto n = erase_if(c, [](const std::string& s) { return s[0] % 2 == 0; });
+
+		assert((n == 5) && "erase_if should return the number removed");
+		for(const auto& s : c) {
+			assert((s.size() == 20 && s[0] % 2 == 1) && "non-trivial values should be moved intact");
+		}
+	}
+	{
+		using C = ring_buffer<pitfall>;
+		C c;
+		fill_wrapped(c, 9, [](int) { return pitfall(); });
+		int i = 0;
+
+		auto n = erase_if(c, [&i](const pitfall&) { return i++ % 3 == 0; });
+
+		assert((n == 3 && c.size() == 6) && "erase_if should remove values");
+		for(const auto& p : c) {
+			p.check();
+		}
+	}
+}
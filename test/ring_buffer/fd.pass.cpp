@@ -0,0 +1,101 @@
+#include "include/ring_buffer_io.hpp"
+
+/*
+ * check read_from and write_to on byte rings, across the wrap,
+ * including partial writes to a full pipe, and growth when full
+ */
+
+#include <cassert>
+#include <string>
+
+#ifdef RING_BUFFER_IO_POSIX
+#include <fcntl.h>
+#endif
+
+int main()
+{
+#ifdef RING_BUFFER_IO_POSIX
+	{
+		int fds[2];
+		assert((pipe(fds) == 0) && "pipe");
+
+		// wrapped source
+		ring_buffer<char> src(16);
+		for(char ch : std::string("..........")) {
+			src.push_back(ch);
+		}
+		src.pop_front_n(10);
+		for(char ch : std::string("hello, world")) {
+			src.push_back(ch);
+		}
+
+		assert((src.second_segment().second > 0) && "source should wrap");
+		assert((write_to(src, fds[1], 5) == 5) && "write_to should stop at max");
+		assert((src.size() == 7 && src.front() == ',') && "written values should be popped");
+		assert((write_to(src, fds[1], 100) == 7 && src.empty()) && "write_to rest");
+		assert((write_to(src, fds[1], 100) == 0) && "write_to with nothing to write");
+
+		// wrapped destination, with 8 free
+		ring_buffer<char> dst(10);
+		for(char ch : std::string("xxxxxx")) {
+			dst.push_back(ch);
+		}
+		dst.pop_front_n(4);
+
+		assert((read_from(dst, fds[0], 100) == 8) && "read_from should stop at free space");
+		assert((dst.capacity() == 10) && "read_from should not grow if not full");
+		assert((std::string(dst.begin(), dst.end()) == "xxhello, w") && "read_from across the wrap");
+
+		assert((read_from(dst, fds[0], 100) == 4) && "read_from should grow a full ring");
+		assert((std::string(dst.begin(), dst.end()) == "xxhello, world") && "read_from after growing");
+
+		close(fds[1]);
+
+		assert((read_from(dst, fds[0], 100) == 0 && dst.size() == 14) && "read_from at end of file");
+
+		close(fds[0]);
+	}
+	{
+		// a consumer which lags, so the ring is full on every read
+		int fds[2];
+		assert((pipe(fds) == 0) && "pipe");
+		std::string data(4000, 'z');
+		assert((write(fds[1], data.data(), data.size()) == 4000) && "fill pipe");
+
+		ring_buffer<char> dst;
+		int grown = 0;
+		while(dst.size() < 4000) {
+			auto cap = dst.capacity();
+			assert((read_from(dst, fds[0], 4) > 0) && "read_from a pipe with data");
+			grown += dst.capacity() != cap;
+		}
+		assert((dst.size() == 4000 && grown < 30) && "a full ring should grow geometrically");
+
+		close(fds[0]);
+		close(fds[1]);
+	}
+	{
+		// partial writes
+		int fds[2];
+		assert((pipe(fds) == 0) && "pipe");
+		fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+
+		const std::size_t big = 1 << 20;
+		ring_buffer<unsigned char> src;
+		src.resize(big);
+
+		auto written = write_to(src, fds[1], big);
+
+		assert((written > 0 && static_cast<std::size_t>(written) < big) && "pipe should take a partial write");
+		assert((src.size() == big - static_cast<std::size_t>(written)) && "the rest should stay in the ring");
+
+		auto again = write_to(src, fds[1], big);
+
+		assert((again < 0 && errno == EAGAIN) && "full pipe should fail");
+		assert((src.size() == big - static_cast<std::size_t>(written)) && "failed write should not pop");
+
+		close(fds[0]);
+		close(fds[1]);
+	}
+#endif
+}
@@ -0,0 +1,90 @@
+#include "include/ring_buffer.hpp"
+
+/*
+ * check insertion in the middle, from either side and across the wrap,
+ * for both trivially copyable and non-trivial values
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <string>
+
+#include "../pitfalls.hpp"
+
+// start the values part way through the memblk, so they wrap around
+template <typename C, typename F>
+void fill_wrapped(C& c, int count, F make)
+{
+	c.reserve(static_cast<typename C::size_type>(count) * 2);
+	for(int i = 0; i < count; ++i) {
+		c.push_back(make(i));
+	}
+	for(int i = 0; i < count; ++i) {
+		c.pop_front();
+	}
+	for(int i = 0; i < count; ++i) {
+		c.push_back(make(i));
+	}
+}
+
+template <typename T, typename F>
+void test(F make)
+{
+	for(int pos = 0; pos <= 10; ++pos) {
+		for(int count = 0; count <= 12; ++count) {
+			using C = ring_buffer<T>;
+			C c;
+			fill_wrapped(c, 10, make);
+			std::deque<T> d(c.begin(), c.end());
+
+			auto it = c.insert(std::next(c.cbegin(), pos), static_cast<typename C::size_type>(count), make(99));
+			for(int i = 0; i < count; ++i) {
+				d.insert(d.begin() + pos, make(99));
+			}
+
+			assert((std::distance(c.begin(), it) == pos) && "insert should return the first inserted value");
+			assert((c.size() == d.size() && std::equal(d.begin(), d.end(), c.begin())) && "fill insert");
+		}
+	}
+	for(int pos = 0; pos <= 10; ++pos) {
+		using C = ring_buffer<T>;
+		C c;
+		fill_wrapped(c, 10, make);
+		std::deque<T> d(c.begin(), c.end());
+		T vals[3] = { make(50), make(51), make(52) };
+
+		c.insert(std::next(c.cbegin(), pos), std::begin(vals), std::end(vals));
+		d.insert(d.begin() + pos, std::begin(vals), std::end(vals));
+
+		assert((c.size() == d.size() && std::equal(d.begin(), d.end(), c.begin())) && "range insert");
+	}
+}
+
+int main()
+{
+	test<int>([](int i) { return i; });
+	test<std::string>([](int i) { return std::string(20, char('a' + i % 26)); });
+
+	{
+		using C = ring_buffer<int>;
+		C c{ 1, 2, 3 };
+
+		c.insert(std::next(c.cbegin()), 3, c.front());
+
+		assert((c.size() == 6 && c[1] == 1 && c[3] == 1 && c[4] == 2) && "insert a value from the same ring");
+	}
+	{
+		using C = ring_buffer<pitfall>;
+		C c(4);
+		c.emplace_back();
+		c.emplace_back();
+
+		c.insert(std::next(c.cbegin()), 5, pitfall());
+
+		assert((c.size() == 7) && "insert should add values");
+		for(const auto& p : c) {
+			p.check();
+		}
+	}
+}
@@ -0,0 +1,175 @@
+#include "include/ring_buffer_io.hpp"
+
+/*
+ * check save and load round trip, for trivial values, values using the
+ * ring_buffer_value_io hook, and through a file descriptor
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#ifdef RING_BUFFER_IO_POSIX
+#include <sys/wait.h>
+#endif
+
+template <>
+struct ring_buffer_value_io<std::string>
+{
+	static void save(std::ostream& os, const std::string& val)
+	{
+		os << val.size() << ' ' << val;
+	}
+
+	static std::string load(std::istream& is)
+	{
+		std::size_t len = 0;
+		is >> len;
+		is.get();
+		std::string val(len, ' ');
+		is.read(&val[0], static_cast<std::streamsize>(len));
+		return val;
+	}
+};
+
+// start the values part way through the memblk, so they wrap around
+template <typename C, typename F>
+void fill_wrapped(C& c, int count, F make)
+{
+	c.reserve(static_cast<typename C::size_type>(count) + 4);
+	for(int i = 0; i < count; ++i) {
+		c.push_back(make(-1));
+	}
+	for(int i = 0; i < count; ++i) {
+		c.pop_front();
+		c.push_back(make(i));
+	}
+}
+
+int main()
+{
+	{
+		using C = ring_buffer<int>;
+		C c;
+		fill_wrapped(c, 10, [](int i) { return i; });
+
+		assert((c.second_segment().second > 0) && "values should wrap");
+		assert((c.first_segment().second + c.second_segment().second == c.size()) && "segments should hold all values");
+
+		std::stringstream ss;
+		assert(save(c, ss) && "save to stream");
+
+		C d{1, 2, 3};
+		assert(load(d, ss) && "load from stream");
+		assert((d.size() == 10 && std::equal(c.begin(), c.end(), d.begin())) && "stream round trip");
+		assert((d.second_segment().second == 0) && "loaded values should be one segment");
+	}
+	{
+		using C = ring_buffer<int>;
+		C c, d{1, 2, 3};
+
+		std::stringstream ss;
+		save(c, ss);
+
+		assert((load(d, ss) && d.empty()) && "round trip of empty ring");
+	}
+	{
+		using C = ring_buffer<std::string>;
+		C c;
+		fill_wrapped(c, 6, [](int i) { return std::string(static_cast<std::size_t>(i + 1), 'a'); });
+
+		std::stringstream ss;
+		save(c, ss);
+
+		C d;
+		assert(load(d, ss) && "load with hook");
+		assert((d.size() == 6 && std::equal(c.begin(), c.end(), d.begin())) && "round trip with hook");
+	}
+	{
+		// wrong type, and cut short
+		using C = ring_buffer<int>;
+		C c{1, 2, 3, 4};
+
+		std::stringstream ss;
+		save(c, ss);
+		auto bytes = ss.str();
+
+		ring_buffer<double> wrong{1.0};
+		std::stringstream ss2(bytes);
+		assert((!load(wrong, ss2) && wrong.empty()) && "load should check value size");
+
+		C d;
+		std::stringstream ss3(bytes.substr(0, bytes.size() - 2));
+		assert((!load(d, ss3) && d.empty()) && "load should fail when cut short");
+
+		// a count far past the data shouldn't be allocated up front
+		std::uint64_t huge = std::uint64_t(1) << 40;
+		std::memcpy(&bytes[8], &huge, sizeof(huge));
+		std::stringstream ss4(bytes);
+		assert((!load(d, ss4) && d.empty()) && "load should fail on a corrupt count");
+
+#ifdef RING_BUFFER_IO_POSIX
+		std::FILE* f = std::tmpfile();
+		assert((f != nullptr) && "tmpfile");
+		int fd = fileno(f);
+		assert((write(fd, bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size())) && "write corrupt file");
+		lseek(fd, 0, SEEK_SET);
+		assert((!load(d, fd) && d.empty()) && "load should check the count against the file size");
+		std::fclose(f);
+
+		int fds[2];
+		assert((pipe(fds) == 0) && "pipe");
+		assert((write(fds[1], bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size())) && "write corrupt pipe");
+		close(fds[1]);
+		assert((!load(d, fds[0]) && d.empty()) && "load should fail on a corrupt count from a pipe");
+		close(fds[0]);
+#endif
+	}
+#ifdef RING_BUFFER_IO_POSIX
+	{
+		using C = ring_buffer<long>;
+		C c;
+		fill_wrapped(c, 100, [](int i) { return static_cast<long>(i) * 3; });
+
+		std::FILE* f = std::tmpfile();
+		assert((f != nullptr) && "tmpfile");
+		int fd = fileno(f);
+
+		assert(save(c, fd) && "save to fd");
+		lseek(fd, 0, SEEK_SET);
+
+		C d;
+		assert(load(d, fd) && "load from fd");
+		assert((d.size() == 100 && std::equal(c.begin(), c.end(), d.begin())) && "fd round trip");
+
+		std::fclose(f);
+	}
+	{
+		// more than one chunk, through a pipe
+		using C = ring_buffer<char>;
+		C c;
+		for(int i = 0; i < 3000000; ++i) {
+			c.push_back(static_cast<char>(i % 127));
+		}
+
+		int fds[2];
+		assert((pipe(fds) == 0) && "pipe");
+		if(fork() == 0) {
+			close(fds[0]);
+			_exit(save(c, fds[1]) ? 0 : 1);
+		}
+		close(fds[1]);
+
+		C d;
+		assert(load(d, fds[0]) && "load from pipe");
+		assert((d.size() == c.size() && std::equal(c.begin(), c.end(), d.begin())) && "pipe round trip");
+		assert((d.capacity() == c.size() && d.second_segment().second == 0) && "chunks should end up as one exact segment");
+		close(fds[0]);
+		wait(nullptr);
+	}
+#endif
+}
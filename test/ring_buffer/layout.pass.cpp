@@ -0,0 +1,75 @@
+#include "include/ring_buffer.hpp"
+
+/*
+ * check the size of the ring itself, and use of a smaller index type
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+// stateless, so should take up no space
+static_assert(sizeof(ring_buffer<int>) <= 4 * sizeof(void*),
+              "ring_buffer should be a pointer and three indices");
+static_assert(sizeof(ring_buffer<int, std::allocator<int>, std::uint32_t>) <= 24,
+              "ring_buffer with 32-bit indices should be at most 24 bytes");
+
+int main()
+{
+	{
+		using C = ring_buffer<int, std::allocator<int>, std::uint32_t>;
+
+		assert((C().max_size() == std::numeric_limits<std::uint32_t>::max() - 1) && "max_size should be limited by the index type");
+	}
+	{
+		// small enough to fill
+		using C = ring_buffer<int, std::allocator<int>, std::uint8_t>;
+		C c;
+		assert((c.max_size() == 254) && "the blank value takes one index");
+
+		for(int i = 0; i < 254; ++i) {
+			c.push_back(i);
+		}
+		assert((c.size() == 254 && c.capacity() == 254 && c.back() == 253) && "growth should stop at max_size");
+
+		bool threw = false;
+		try {
+			c.push_back(254);
+		} catch(std::length_error&) {
+			threw = true;
+		}
+		assert((threw && c.size() == 254 && c.front() == 0) && "growing past max_size should throw, keeping the ring");
+
+		threw = false;
+		try {
+			C d;
+			d.reserve(255);
+		} catch(std::length_error&) {
+			threw = true;
+		}
+		assert((threw) && "reserving past max_size should throw");
+	}
+	{
+		using C = ring_buffer<int, std::allocator<int>, std::uint32_t>;
+		C c(4);
+		for(int i = 0; i < 20; ++i) {
+			c.push_back(i);
+			c.push_front(-i);
+		}
+
+		C d(std::move(c));
+		C e;
+		e = d;
+
+		assert((c.empty() && c.capacity() == 0) && "moved from ring should be empty");
+		assert((d.size() == 40 && d.front() == -19 && d.back() == 19) && "push with 32-bit indices");
+		assert((e.size() == 40 && std::equal(d.begin(), d.end(), e.begin())) && "copy with 32-bit indices");
+
+		swap(d, c);
+
+		assert((c.size() == 40 && d.empty()) && "swap with 32-bit indices");
+	}
+}
@@ -7,10 +7,10 @@
 
 #include <memory>
 
-template <typename T, typename A>
+template <typename T, typename A, typename P = ring_buffer_keep_capacity>
 void test()
 {
-	using C = ring_buffer<T, A>;
+	using C = ring_buffer<T, A, typename std::allocator_traits<A>::size_type, P>;
 	T vals[4];
 
 	// {{{ basic fns
@@ -64,6 +64,11 @@ void test()
 	ca.end();
 	ca.cend();
 
+	a.first_segment();
+	ca.first_segment();
+	a.second_segment();
+	ca.second_segment();
+
 	a.rbegin();
 	ca.rbegin();
 	ca.crbegin();
@@ -87,11 +92,15 @@ void test()
 	// {{{ modifiers
 
 	a.clear();
+	a.release();
 	a.insert(a.begin(), vals[0]);
 	a.insert(a.begin(), std::move(vals[0]));
-	// a.insert(a.begin(), 5, vals[0])
+	a.insert(a.begin(), 5, vals[0]);
 	a.insert(a.begin(), std::begin(vals), std::end(vals));
 	a.insert(a.begin(), {vals[0], vals[1]});
+	a.erase(a.begin());
+	a.erase(a.begin(), a.end());
+	erase_if(a, [](const T&) { return true; });
 
 	a.push_front(vals[0]);
 	a.push_front(std::move(vals[0]));
@@ -102,6 +111,12 @@ void test()
 	a.push_back(std::move(vals[0]));
 	a.emplace_back();
 	a.pop_back();
+	a.pop_front_n(1);
+	a.pop_back_n(1);
+
+	a.resize(4);
+	a.resize(5, vals[0]);
+	a.resize_for_overwrite(6);
 
 	a.swap(b);
 
@@ -115,6 +130,7 @@ void check()
 	// don't actually call it
 	// but still instantiate the function
 	test<int, std::allocator<int>>();
+	test<int, std::allocator<int>, ring_buffer_shrink_hysteresis<>>();
 }
 
 int main()
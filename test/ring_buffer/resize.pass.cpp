@@ -0,0 +1,107 @@
+#include "include/ring_buffer.hpp"
+
+/*
+ * check resize, resize_for_overwrite, assign and pop_*_n, across the wrap
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+#include "../pitfalls.hpp"
+
+// start the values part way through the memblk, so they wrap around
+template <typename C>
+void fill_wrapped(C& c, int count, typename C::const_reference val)
+{
+	c.reserve(static_cast<typename C::size_type>(count) * 2);
+	for(int i = 0; i < count; ++i) {
+		c.push_back(val);
+	}
+	for(int i = 0; i < count; ++i) {
+		c.pop_front();
+	}
+	for(int i = 0; i < count; ++i) {
+		c.push_back(val);
+	}
+}
+
+int main()
+{
+	{
+		using C = ring_buffer<int>;
+		C c;
+		fill_wrapped(c, 6, 7);
+
+		c.resize(14);
+
+		assert((c.size() == 14) && "resize up");
+		assert((std::count(c.begin(), c.end(), 0) == 8) && "resize should value init");
+
+		c.resize(3);
+
+		assert((c.size() == 3 && c.back() == 7) && "resize down");
+
+		c.resize(5, 9);
+
+		assert((c.size() == 5 && c[3] == 9 && c[4] == 9) && "resize with value");
+
+		c.resize_for_overwrite(40);
+
+		assert((c.size() == 40 && c[2] == 7) && "resize_for_overwrite should keep old values");
+
+		c.resize_for_overwrite(2);
+
+		assert((c.size() == 2) && "resize_for_overwrite down");
+	}
+	{
+		using C = ring_buffer<std::string>;
+		C c;
+		fill_wrapped(c, 6, std::string(30, 'x'));
+
+		c.resize_for_overwrite(9);
+
+		assert((c.size() == 9 && c.back().empty()) && "non-trivial resize_for_overwrite should still construct");
+
+		c.pop_front_n(4);
+
+		assert((c.size() == 5 && c.front() == std::string(30, 'x')) && "pop_front_n");
+
+		c.pop_back_n(3);
+
+		assert((c.size() == 2) && "pop_back_n");
+	}
+	{
+		using C = ring_buffer<std::string>;
+		C c;
+		fill_wrapped(c, 6, "a");
+
+		c.assign(4, "b");
+
+		assert((c.size() == 4 && std::count(c.begin(), c.end(), "b") == 4) && "assign fewer");
+
+		c.assign(8, c.front());
+
+		assert((c.size() == 8 && std::count(c.begin(), c.end(), "b") == 8) && "assign more, from the same ring");
+
+		c.assign(30, c.back());
+
+		assert((c.size() == 30 && std::count(c.begin(), c.end(), "b") == 30) && "assign with reallocation, from the same ring");
+	}
+	{
+		using C = ring_buffer<pitfall>;
+		C c;
+		fill_wrapped(c, 5, pitfall());
+
+		c.resize(12);
+		c.pop_front_n(3);
+		c.assign(7, pitfall());
+		c.resize(2, pitfall());
+		c.pop_back_n(1);
+
+		assert((c.size() == 1) && "pitfalls");
+		for(const auto& p : c) {
+			p.check();
+		}
+	}
+}
@@ -0,0 +1,113 @@
+#include "include/ring_buffer.hpp"
+
+/*
+ * check that clear keeps capacity, release frees it, and the hysteresis
+ * shrink policy only shrinks after staying below the low-water mark
+ */
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "../pitfalls.hpp"
+
+int main()
+{
+	{
+		using C = ring_buffer<pitfall>;
+		C c;
+		for(int i = 0; i < 20; ++i) {
+			c.push_back(pitfall());
+		}
+		auto cap = c.capacity();
+
+		c.clear();
+
+		assert((c.empty() && c.capacity() == cap) && "clear should keep capacity");
+
+		for(int i = 0; i < 20; ++i) {
+			c.push_front(pitfall());
+		}
+
+		assert((c.size() == 20 && c.capacity() == cap) && "refill after clear should not reallocate");
+
+		c.release();
+
+		assert((c.empty() && c.capacity() == 0) && "release should free the memblk");
+	}
+	{
+		// pops never shrink by default
+		using C = ring_buffer<int>;
+		C c(64);
+		c.push_back(1);
+		for(int i = 0; i < 5000; ++i) {
+			c.push_back(i);
+			c.pop_front();
+		}
+
+		assert((c.capacity() == 64) && "default policy should keep capacity");
+	}
+	{
+		using C = ring_buffer<std::string, std::allocator<std::string>, std::size_t,
+		                      ring_buffer_shrink_hysteresis<1, 4, 8>>;
+		C c(64);
+		c.insert(c.end(), 20, std::string("v"));
+
+		// 20 values is above 64 / 4, so stays
+		for(int i = 0; i < 100; ++i) {
+			c.push_back(std::to_string(i));
+			c.pop_front();
+		}
+
+		assert((c.capacity() == 64) && "should not shrink above the low-water mark");
+
+		// 7 ops below: not yet
+		c.pop_front_n(18);
+		for(int i = 0; i < 3; ++i) {
+			c.push_back("x");
+			c.pop_back();
+		}
+
+		assert((c.capacity() == 64) && "should not shrink before enough ops");
+
+		// the 8th op below halves
+		c.pop_front();
+
+		assert((c.capacity() == 32) && "should halve after enough ops below the mark");
+		assert((c.size() == 1 && c[0] == "99") && "values should survive shrinking");
+
+		// going above the mark resets the count
+		for(int i = 0; i < 8; ++i) {
+			c.push_back("y");
+		}
+		c.pop_back_n(3);
+
+		// 7 more ops below, one short of shrinking
+		for(int i = 0; i < 3; ++i) {
+			c.push_back("z");
+			c.pop_back();
+		}
+
+		assert((c.capacity() == 32 && c.size() == 6) && "count should reset above the mark");
+	}
+	{
+		// shrinks all the way down, and still works afterwards
+		using C = ring_buffer<int, std::allocator<int>, std::size_t,
+		                      ring_buffer_shrink_hysteresis<1, 4, 1>>;
+		C c(16);
+		c.push_back(1);
+		c.pop_back();
+		c.pop_front_n(0);
+		for(int i = 0; i < 10; ++i) {
+			c.push_back(i);
+			c.pop_back();
+		}
+
+		assert((c.capacity() <= 2) && "should shrink down to nothing");
+
+		c.push_back(5);
+
+		assert((c.size() == 1 && c.front() == 5) && "push after shrinking");
+	}
+}
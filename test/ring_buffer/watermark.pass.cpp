@@ -0,0 +1,143 @@
+#include "include/ring_buffer.hpp"
+#include "include/ring_buffer_io.hpp"
+#include "include/concurrent_ring_buffer.hpp"
+
+/*
+ * check that watermark callbacks fire once per crossing, from every kind of
+ * size change, and not when values are only moved to a new memblk or read
+ * into the free space
+ */
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+using C = ring_buffer<int, std::allocator<int>, std::size_t, ring_buffer_keep_capacity, ring_buffer_watermark>;
+
+struct counts
+{
+	int high = 0;
+	int low = 0;
+};
+
+void watch(ring_buffer_watermark& wm, counts& n, std::size_t high, std::size_t low)
+{
+	wm.high = high;
+	wm.low = low;
+	wm.on_high = [&n] { ++n.high; };
+	wm.on_low = [&n] { ++n.low; };
+}
+
+} // namespace
+
+int main()
+{
+	{
+		C c;
+		counts n;
+		watch(c.watermark(), n, 8, 2);
+
+		// grows several times on the way
+		for(int i = 0; i < 7; ++i) {
+			c.push_back(i);
+		}
+		assert((n.high == 0) && "below high");
+		c.push_front(-1);
+		assert((n.high == 1) && "reaching high fires");
+		c.push_back(8);
+		c.push_back(9);
+		assert((n.high == 1) && "staying above high doesn't fire again");
+
+		c.pop_front_n(7);
+		assert((n.low == 0 && c.size() == 3) && "above low");
+		c.pop_back();
+		assert((n.low == 1) && "reaching low fires");
+		c.pop_front();
+		assert((n.low == 1) && "staying below low doesn't fire again");
+
+		c.insert(c.begin(), 10, 5);
+		assert((n.high == 2) && "insert crossing high");
+		c.erase(c.begin(), std::next(c.begin(), 9));
+		assert((n.low == 2) && "erase crossing low");
+
+		c.resize(20);
+		c.clear();
+		assert((n.high == 3 && n.low == 3) && "resize and clear crossing");
+
+		c.shrink_to_fit();
+		c.reserve(100);
+		assert((n.high == 3 && n.low == 3) && "moving values doesn't fire");
+	}
+	{
+		// watermarks stay with their rings when swapping
+		C a, b;
+		counts na, nb;
+		watch(a.watermark(), na, 4, 0);
+		watch(b.watermark(), nb, 4, 0);
+		b.assign(6, 1);
+		assert((nb.high == 1) && "assign crossing high");
+
+		a.swap(b);
+		assert((na.high == 1 && nb.low == 1) && "swap should tell both watermarks");
+	}
+	{
+		int fds[2];
+		assert((::pipe(fds) == 0) && "pipe");
+
+		C c;
+		c.watermark().high = 2;
+		c.watermark().on_high = ring_buffer_eventfd_notify{ fds[1] };
+		c.push_back(1);
+		c.push_back(2);
+
+		std::uint64_t got = 0;
+		assert((::read(fds[0], &got, sizeof(got)) == sizeof(got) && got == 1) && "eventfd notify should write a count of 1");
+		::close(fds[0]);
+		::close(fds[1]);
+	}
+	{
+		// read_from only adds what it read
+		using B = ring_buffer<char, std::allocator<char>, std::size_t, ring_buffer_keep_capacity, ring_buffer_watermark>;
+		int fds[2];
+		assert((::pipe(fds) == 0) && "pipe");
+
+		B c(64);
+		counts n;
+		watch(c.watermark(), n, 32, 8);
+		for(int i = 0; i < 4; ++i) {
+			c.push_back('a');
+		}
+
+		assert((::write(fds[1], "bcd", 3) == 3) && "write to pipe");
+		assert((read_from(c, fds[0], 100) == 3 && c.size() == 7) && "read_from");
+		assert((n.high == 0 && n.low == 0) && "read_from shouldn't pass through a bigger size");
+
+		std::string more(30, 'e');
+		assert((::write(fds[1], more.data(), more.size()) == 30) && "write to pipe");
+		assert((read_from(c, fds[0], 100) == 30 && c.size() == 37) && "read_from");
+		assert((n.high == 1 && n.low == 0) && "read_from crossing high");
+
+		::close(fds[0]);
+		::close(fds[1]);
+	}
+	{
+		concurrent_ring_buffer<int, std::allocator<int>, ring_buffer_watermark> q;
+		counts n;
+		watch(q.watermark(), n, 4, 1);
+
+		std::vector<int> vals = { 1, 2, 3, 4, 5 };
+		q.push_many(vals.begin(), vals.end());
+		assert((n.high == 1) && "batch push crossing high");
+
+		int out[5];
+		q.pop_many(out, 3);
+		assert((n.low == 0) && "above low");
+		q.pop_many(out, 5);
+		assert((n.low == 1) && "batch pop crossing low");
+	}
+}
@@ -0,0 +1,126 @@
+#include "include/ring_channel.hpp"
+
+/*
+ * check that push and pop suspend and resume in order, for buffered and
+ * unbuffered channels, and that close wakes everyone
+ *
+ * note: needs C++20, otherwise there is nothing to check
+ */
+
+#include <cassert>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+
+namespace {
+
+ring_task producer(ring_channel<std::string>& ch, int count, int& pushed)
+{
+	for(int i = 0; i < count; ++i) {
+		co_await ch.push(std::to_string(i));
+		++pushed;
+	}
+	ch.close();
+}
+
+ring_task consumer(ring_channel<std::string>& ch, std::vector<std::string>& out)
+{
+	while(auto val = co_await ch.pop()) {
+		out.push_back(std::move(*val));
+	}
+}
+
+ring_task push_one(ring_channel<int>& ch, int val, int& failed)
+{
+	bool ok = co_await ch.push(val);
+	if(!ok) {
+		++failed;
+	}
+}
+
+ring_task pop_one(ring_channel<int>& ch, std::vector<std::optional<int>>& out)
+{
+	out.push_back(co_await ch.pop());
+}
+
+void check(std::size_t cap)
+{
+	ring_executor ex;
+	ring_channel<std::string> ch(ex, cap);
+	std::vector<std::string> out;
+	int pushed = 0;
+
+	ex.spawn(producer(ch, 100, pushed));
+	ex.spawn(consumer(ch, out));
+	ex.run();
+
+	assert((pushed == 100 && out.size() == 100) && "all values should get through");
+	for(int i = 0; i < 100; ++i) {
+		assert((out[static_cast<std::size_t>(i)] == std::to_string(i)) && "values should stay in order");
+	}
+	assert((ex.empty() && ch.size() == 0) && "nothing should be left");
+}
+
+} // namespace
+
+int main()
+{
+	check(4);
+	check(1);
+	check(0);
+
+	{
+		// producer fills up, and must wait for the consumer
+		ring_executor ex;
+		ring_channel<std::string> ch(ex, 3);
+		int pushed = 0;
+
+		ex.spawn(producer(ch, 10, pushed));
+		ex.run();
+
+		assert((pushed == 3 && ch.size() == 3) && "push should suspend when full");
+
+		auto val = ch.try_pop();
+		ex.run();
+
+		assert((val == "0" && pushed == 4 && ch.size() == 3) && "pop should let a pusher in");
+
+		// let the producer finish
+		ch.close();
+		ex.run();
+
+		assert((pushed == 10 && ch.size() == 3) && "push after close should fail");
+	}
+	{
+		// waiters in both directions are woken by close
+		ring_executor ex;
+		ring_channel<int> full(ex, 1), empty(ex, 1);
+		int failed = 0;
+		std::vector<std::optional<int>> out;
+
+		ex.spawn(push_one(full, 1, failed));
+		ex.spawn(push_one(full, 2, failed));
+		ex.spawn(pop_one(empty, out));
+		ex.spawn(pop_one(empty, out));
+		ex.run();
+
+		assert((failed == 0 && out.empty()) && "should be waiting");
+
+		full.close();
+		empty.close();
+		ex.run();
+
+		assert((failed == 1 && out.size() == 2 && !out[0] && !out[1]) && "close should wake waiters");
+		assert((full.try_pop() == 1) && "values pushed before close can still be popped");
+	}
+}
+
+#else
+
+int main()
+{
+}
+
+#endif
@@ -0,0 +1,117 @@
+#include "include/ring_streambuf.hpp"
+
+/*
+ * check reading and writing a ring through iostreams, across the wrap,
+ * and seeking within the window
+ */
+
+#include <cassert>
+#include <istream>
+#include <ostream>
+#include <string>
+
+int main()
+{
+	{
+		ring_buffer<char> ring;
+		ring_streambuf buf(ring);
+		std::ostream os(&buf);
+		std::istream is(&buf);
+
+		os << "hello " << 42 << ' ' << 1.5 << '\n';
+
+		std::string word;
+		int num = 0;
+		double dbl = 0;
+		is >> word >> num >> dbl;
+
+		assert((word == "hello" && num == 42 && dbl == 1.5) && "round trip through streams");
+
+		buf.pubsync();
+
+		assert((ring.size() == 1 && ring.front() == '\n') && "sync should pop read values and trim the back");
+	}
+	{
+		// values already in the ring, wrapping around the memblk
+		ring_buffer<char> ring(8);
+		for(char ch : std::string("xxxxxx")) {
+			ring.push_back(ch);
+		}
+		ring.pop_front_n(6);
+		for(char ch : std::string("line1\nl2")) {
+			ring.push_back(ch);
+		}
+
+		ring_streambuf buf(ring);
+		std::istream is(&buf);
+
+		std::string a, b;
+		std::getline(is, a);
+		std::getline(is, b);
+
+		assert((a == "line1" && b == "l2") && "read across the wrap");
+		assert((is.eof()) && "read to the end");
+	}
+	{
+		// bulk write and read, larger than a segment
+		ring_buffer<char> ring;
+		ring_streambuf buf(ring);
+
+		std::string data;
+		for(int i = 0; i < 1000; ++i) {
+			data += static_cast<char>('a' + i % 26);
+		}
+
+		for(int i = 0; i < 3; ++i) {
+			assert((buf.sputn(data.data(), 700) == 700) && "sputn");
+
+			std::string out(700, ' ');
+			assert((buf.sgetn(&out[0], 700) == 700) && "sgetn");
+			assert((out == data.substr(0, 700)) && "bulk round trip");
+
+			buf.pubsync();
+		}
+
+		assert((ring.empty()) && "all read");
+
+		buf.sputn(data.data(), 10);
+		std::string out(20, ' ');
+
+		assert((buf.sgetn(&out[0], 20) == 10) && "sgetn should stop at the end");
+	}
+	{
+		ring_buffer<char> ring;
+		ring_streambuf buf(ring);
+		std::iostream io(&buf);
+
+		io << "abcdef";
+		char ch = 0;
+		io.get(ch);
+		io.get(ch);
+
+		assert((ch == 'b') && "get");
+		assert((io.tellg() == 2) && "tellg");
+
+		io.seekg(0);
+		io.get(ch);
+
+		assert((ch == 'a') && "seek back within the window");
+
+		io.seekg(-1, std::ios_base::end);
+		io.get(ch);
+
+		assert((ch == 'f') && "seek from the end");
+
+		// read values are dropped on sync, so can't be sought to
+		io.seekg(3);
+		buf.pubsync();
+		io.seekg(1);
+
+		assert((io.fail()) && "seek before the window should fail");
+
+		io.clear();
+		io.seekg(0, std::ios_base::end);
+
+		assert((io.tellg() == 6) && "positions count from the first value read");
+	}
+}
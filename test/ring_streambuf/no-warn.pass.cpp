@@ -0,0 +1,34 @@
+#include "include/ring_streambuf.hpp"
+
+/*
+ * check that compilation produces no warnings
+ * preferrably, use -Weverything -Wno-c++98-compat
+ */
+
+#include <iostream>
+
+void check();
+
+void check()
+{
+	// don't actually call it
+	// but still instantiate the functions
+	ring_buffer<char> ring;
+	ring_streambuf buf(ring);
+	std::iostream io(&buf);
+
+	char data[4] = {};
+	io << 1;
+	io >> data[0];
+	io.write(data, 4);
+	io.read(data, 4);
+	io.seekg(0);
+	io.tellg();
+	buf.in_avail();
+	buf.pubsync();
+	buf.ring();
+}
+
+int main()
+{
+}
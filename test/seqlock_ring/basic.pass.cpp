@@ -0,0 +1,68 @@
+#include "include/seqlock_ring.hpp"
+
+/*
+ * check that snapshots are the latest values, oldest first, and that
+ * snapshots taken while a writer overwrites are never torn
+ */
+
+#include <atomic>
+#include <cassert>
+#include <thread>
+
+namespace {
+
+// every field is the same, so a torn value shows up as a mismatch
+struct sample
+{
+	long a, b, c, d;
+};
+
+} // namespace
+
+int main()
+{
+	{
+		seqlock_ring<int> ring(4);
+		int out[8];
+
+		assert((ring.latest(out, 4) == 0) && "nothing written yet");
+
+		ring.push(1);
+		ring.push(2);
+		assert((ring.latest(out, 4) == 2 && out[0] == 1 && out[1] == 2) && "fewer written than asked for");
+
+		for(int i = 3; i <= 10; ++i) {
+			ring.push(i);
+		}
+		assert((ring.written() == 10) && "written should count every push");
+		assert((ring.latest(out, 8) == 4) && "at most capacity values");
+		for(int i = 0; i < 4; ++i) {
+			assert((out[i] == 7 + i) && "latest values, oldest first");
+		}
+		assert((ring.latest(out, 1) == 1 && out[0] == 10) && "latest single value");
+	}
+	{
+		const long total = 200000;
+		seqlock_ring<sample> ring(64);
+		std::atomic<bool> done(false);
+
+		std::thread writer([&] {
+			for(long i = 0; i < total; ++i) {
+				ring.push(sample{ i, i, i, i });
+			}
+			done = true;
+		});
+
+		sample out[16];
+		while(!done.load()) {
+			auto count = ring.latest(out, 16);
+			for(std::size_t i = 0; i < count; ++i) {
+				assert((out[i].a == out[i].b && out[i].b == out[i].c && out[i].c == out[i].d) && "values should not be torn");
+				assert((i == 0 || out[i].a == out[i - 1].a + 1) && "snapshot should be consecutive values");
+			}
+		}
+		writer.join();
+
+		assert((ring.latest(out, 1) == 1 && out[0].a == total - 1) && "should end with the last value");
+	}
+}
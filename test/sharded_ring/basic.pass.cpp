@@ -0,0 +1,124 @@
+#include "include/sharded_ring.hpp"
+
+/*
+ * check that each thread gets its own shard, that collect sees every value
+ * with per-shard order kept, that collect_merged orders by key across shards,
+ * and that full shards drop and count values
+ */
+
+#include <cassert>
+#include <thread>
+#include <utility>
+#include <vector>
+
+int main()
+{
+	{
+		// (thread, sequence number) pairs
+		using event = std::pair<int, int>;
+		const int threads = 4;
+		const int per_thread = 1000;
+
+		sharded_ring<event> ring(per_thread);
+		std::vector<std::thread> pool;
+		for(int t = 0; t < threads; ++t) {
+			pool.emplace_back([&ring, t] {
+				for(int i = 0; i < per_thread; ++i) {
+					ring.push(event(t, i));
+				}
+			});
+		}
+		for(auto& th : pool) {
+			th.join();
+		}
+
+		assert((ring.shard_count() == threads) && "one shard per pushing thread");
+		assert((ring.dropped() == 0) && "shards were big enough");
+
+		std::vector<int> next(threads, 0);
+		auto count = ring.collect([&](event&& ev) {
+			auto t = static_cast<std::size_t>(ev.first);
+			assert((ev.second == next[t]) && "each shard should stay in push order");
+			++next[t];
+		});
+		assert((count == threads * per_thread) && "collect should see every value");
+		assert((ring.collect([](event&&) {}) == 0) && "collect drains");
+	}
+	{
+		// timestamps interleaved across threads, in order within each
+		sharded_ring<int> ring(16);
+		std::thread odd([&] {
+			for(int i = 1; i < 20; i += 2) {
+				ring.push(i);
+			}
+		});
+		odd.join();
+		for(int i = 0; i < 20; i += 2) {
+			ring.push(i);
+		}
+
+		std::vector<int> out;
+		auto count = ring.collect_merged([&](int&& val) { out.push_back(val); }, [](int val) { return val; });
+		assert((count == 20 && out.size() == 20) && "merge should see every value");
+		for(std::size_t i = 0; i < 20; ++i) {
+			assert((out[i] == static_cast<int>(i)) && "merge should order by key across shards");
+		}
+	}
+	{
+		sharded_ring<int> ring(4);
+		int pushed = 0;
+		for(int i = 0; i < 10; ++i) {
+			pushed += ring.push(i);
+		}
+		assert((pushed == 4 && ring.dropped() == 6) && "a full shard should drop and count");
+
+		ring.collect([](int&&) {});
+		assert((ring.push(10)) && "space again after collecting");
+	}
+	{
+		// rings are told apart, even when a new one reuses an old address
+		for(int round = 0; round < 3; ++round) {
+			sharded_ring<int> ring(4);
+			ring.push(round);
+			int seen = -1;
+			assert((ring.collect([&](int&& val) { seen = val; }) == 1 && seen == round) && "fresh ring should get a fresh shard");
+		}
+	}
+	{
+		// entries for destroyed rings are pruned
+		sharded_ring<int> kept(4);
+		kept.push(-1);
+		for(int round = 0; round < 1000; ++round) {
+			sharded_ring<int> ring(4);
+			ring.push(round);
+			assert((sharded_ring<int>::local_shard_count() <= 2) && "entries for destroyed rings should be pruned");
+		}
+		kept.push(-2);
+		assert((sharded_ring<int>::local_shard_count() == 1) && "only the live ring should be left");
+
+		std::vector<int> out;
+		kept.collect([&](int&& val) { out.push_back(val); });
+		assert((out == std::vector<int>{ -1, -2 }) && "the live ring's shard should be kept");
+	}
+	{
+		// shards of exited threads are freed once drained
+		sharded_ring<int> ring(4);
+		int total = 0;
+		for(int round = 0; round < 50; ++round) {
+			std::thread worker([&] {
+				for(int i = 0; i < 6; ++i) {
+					ring.push(round);
+				}
+			});
+			worker.join();
+			assert((ring.shard_count() == 1) && "an exited thread's shard is kept until drained");
+
+			total += static_cast<int>(ring.collect([&](int&& val) { assert((val == round) && "values of the exited thread"); }));
+			assert((ring.shard_count() == 0) && "a drained shard of an exited thread should be freed");
+		}
+		assert((total == 50 * 4 && ring.dropped() == 50 * 2) && "freed shards should still count dropped values");
+
+		ring.push(-1);
+		assert((ring.collect([](int&&) {}) == 1 && ring.shard_count() == 1) && "a running thread's shard is kept");
+	}
+}
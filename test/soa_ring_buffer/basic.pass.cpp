@@ -0,0 +1,200 @@
+#include "include/soa_ring_buffer.hpp"
+
+/*
+ * check pushing and popping at both ends across growth, proxy references
+ * and range-for, that each column's two segments hold its values in order
+ * once wrapped, and that a throwing field leaves nothing behind
+ */
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <tuple>
+
+namespace {
+
+// counts live instances, and throws from a copy once fail_after copies have
+// been made. its move can throw, so is never used when growing
+struct tracked
+{
+	static int live;
+	static int fail_after;
+
+	int val;
+
+	explicit tracked(int v)
+		: val(v)
+	{
+		++live;
+	}
+
+	tracked(const tracked& other)
+		: val(other.val)
+	{
+		if(fail_after == 0) {
+			throw val;
+		}
+		--fail_after;
+		++live;
+	}
+
+	tracked& operator=(const tracked&) = default;
+
+	~tracked()
+	{
+		--live;
+	}
+};
+
+int tracked::live = 0;
+int tracked::fail_after = -1;
+
+template <typename F>
+bool throws(F f)
+{
+	try {
+		f();
+	} catch(int) {
+		tracked::fail_after = -1;
+		return true;
+	}
+	tracked::fail_after = -1;
+	return false;
+}
+
+} // namespace
+
+int main()
+{
+	{
+		// {timestamp, price, qty, flags}
+		soa_ring_buffer<std::uint64_t, double, int, std::uint8_t> ticks(4);
+
+		for(int i = 0; i < 4; ++i) {
+			ticks.push_back(std::uint64_t(i), i * 1.5, i * 10, std::uint8_t(i & 1));
+		}
+		assert((ticks.size() == 4 && ticks.capacity() == 4) && "fill to capacity");
+
+		// wrap without growing
+		ticks.pop_front();
+		ticks.pop_front();
+		ticks.push_back(std::uint64_t(4), 6.0, 40, std::uint8_t(0));
+		ticks.push_back(std::uint64_t(5), 7.5, 50, std::uint8_t(1));
+		assert((ticks.capacity() == 4) && "should not have grown");
+
+		auto one = ticks.first_segment<1>();
+		auto two = ticks.second_segment<1>();
+		assert((one.second + two.second == 4 && two.second > 0) && "wrapped column should be in two segments");
+
+		double sum = std::accumulate(one.first, one.first + one.second, 0.0);
+		sum = std::accumulate(two.first, two.first + two.second, sum);
+		assert((sum == 3.0 + 4.5 + 6.0 + 7.5) && "column scan over both segments");
+
+		// proxies
+		std::get<2>(ticks[0]) = 99;
+		assert((ticks.get<2>(0) == 99 && std::get<0>(ticks.front()) == 2) && "proxy references should refer to the fields");
+
+		std::uint64_t expected = 2;
+		for(auto rec : ticks) {
+			assert((std::get<0>(rec) == expected) && "range-for should be in order");
+			std::get<1>(rec) *= 2;
+			++expected;
+		}
+		assert((ticks.get<1>(3) == 15.0) && "writes through range-for proxies");
+
+		// grow while wrapped, at both ends
+		ticks.push_front(std::uint64_t(1), 0.0, 0, std::uint8_t(0));
+		ticks.push_back(std::uint64_t(6), 0.0, 0, std::uint8_t(0));
+		assert((ticks.size() == 6 && ticks.capacity() >= 6) && "should grow");
+		for(std::size_t i = 0; i < ticks.size(); ++i) {
+			assert((ticks.get<0>(i) == i + 1) && "values should keep their order when growing");
+		}
+
+		ticks.reserve(16);
+		assert((ticks.second_segment<0>().second == 0 && ticks.first_segment<0>().second == 6) && "reallocating should unwrap");
+		assert((ticks.get<0>(5) == 6) && "values should keep their order when reserving");
+	}
+	{
+		// non-trivial columns are constructed and destroyed
+		auto counted = std::make_shared<int>(0);
+		{
+			soa_ring_buffer<std::string, std::shared_ptr<int>> c;
+			for(int i = 0; i < 20; ++i) {
+				c.push_back(std::to_string(i), counted);
+			}
+			assert((counted.use_count() == 21) && "each value should hold a copy");
+
+			c.pop_back();
+			c.pop_front();
+			assert((counted.use_count() == 19) && "popping should destroy fields");
+
+			auto copy = c;
+			assert((copy.size() == 18 && std::get<0>(copy.front()) == "1") && "copy");
+			assert((counted.use_count() == 37) && "copy should copy fields");
+
+			soa_ring_buffer<std::string, std::shared_ptr<int>> moved(std::move(copy));
+			assert((copy.empty() && moved.size() == 18) && "move");
+
+			c.clear();
+			assert((c.empty() && counted.use_count() == 19) && "clear should destroy fields");
+		}
+		assert((counted.use_count() == 1) && "destroying should destroy fields");
+	}
+	{
+		using C = soa_ring_buffer<tracked, tracked>;
+		C c(4);
+		for(int i = 0; i < 3; ++i) {
+			c.push_back(tracked(i), tracked(-i));
+		}
+		c.pop_front();
+		c.push_back(tracked(3), tracked(-3)); // wrapped
+		assert((tracked::live == 6) && "two fields per value");
+
+		// second field throws, so the first must be destroyed
+		tracked a(10), b(-10);
+		tracked::fail_after = 1;
+		assert((throws([&] { c.push_back(a, b); })) && "push_back should throw");
+		assert((c.size() == 3 && tracked::live == 8) && "push_back should leave nothing behind");
+
+		// throws part way through the second column while growing
+		tracked::fail_after = 4;
+		assert((throws([&] { c.reserve(16); })) && "reserve should throw");
+		assert((c.capacity() == 4 && c.size() == 3 && tracked::live == 8) && "failed growth should leave the ring unchanged");
+		for(int i = 0; i < 3; ++i) {
+			assert((c.get<0>(static_cast<std::size_t>(i)).val == i + 1 && c.get<1>(static_cast<std::size_t>(i)).val == -(i + 1)) && "values should be intact");
+		}
+
+		tracked::fail_after = 4;
+		assert((throws([&] { C copy(c); })) && "copy should throw");
+		assert((tracked::live == 8) && "failed copy should leave nothing behind");
+
+		c.reserve(16);
+		assert((c.capacity() == 16 && tracked::live == 8) && "growth should move every value");
+	}
+	{
+		// the first column could move, but the second must copy, so both
+		// copy, or a throw in the second would lose the first
+		using C = soa_ring_buffer<std::string, tracked>;
+		C c(2);
+		c.push_back(std::string(20, 'a'), tracked(1));
+		c.push_back(std::string(20, 'b'), tracked(2));
+
+		tracked::fail_after = 1;
+		assert((throws([&] { c.reserve(8); })) && "reserve should throw");
+		assert((c.capacity() == 2 && c.size() == 2) && "failed growth should leave the ring unchanged");
+		assert((c.get<0>(0) == std::string(20, 'a') && c.get<0>(1) == std::string(20, 'b')) && "failed growth should not move the first column");
+
+		c.reserve(8);
+		assert((c.get<0>(1) == std::string(20, 'b') && c.get<1>(1).val == 2) && "growth should keep every column");
+	}
+	assert((tracked::live == 0) && "every tracked value should be destroyed once");
+	{
+		// pushing a value from the ring itself, while growing
+		soa_ring_buffer<std::string> c(1);
+		c.push_back("self");
+		c.push_back(c.get<0>(0));
+		assert((c.size() == 2 && c.get<0>(1) == "self") && "push of own value while growing");
+	}
+}
@@ -0,0 +1,94 @@
+#include "include/spsc_ring.hpp"
+
+/*
+ * check full/empty, wrapping, that values left in the ring are destroyed,
+ * that consume_all keeps its progress if f throws, and a producer and consumer thread handing over values in order
+ */
+
+#include <cassert>
+#include <memory>
+#include <string>
+#include <thread>
+
+int main()
+{
+	{
+		spsc_ring<std::string> ring(3);
+		std::string out;
+
+		assert((ring.capacity() == 4) && "capacity should round up to a power of two");
+		assert((!ring.try_pop(out) && ring.empty()) && "should start empty");
+
+		for(int i = 0; i < 4; ++i) {
+			assert((ring.try_push(std::to_string(i))) && "push until full");
+		}
+		assert((!ring.try_push("x") && ring.size() == 4) && "should be full");
+
+		assert((ring.try_pop(out) && out == "0") && "pop oldest first");
+		assert((ring.try_push("4")) && "space after a pop");
+
+		std::string seen;
+		assert((ring.consume_all([&](std::string&& val) { seen += val; }) == 4) && "consume everything");
+		assert((seen == "1234" && ring.empty()) && "consume in order across the wrap");
+	}
+	{
+		// values still in the ring are destroyed with it
+		auto counted = std::make_shared<int>(0);
+		{
+			spsc_ring<std::shared_ptr<int>> ring(8);
+			ring.try_push(counted);
+			ring.try_push(counted);
+			assert((counted.use_count() == 3) && "ring should hold copies");
+		}
+		assert((counted.use_count() == 1) && "destroying the ring should destroy its values");
+	}
+	{
+		// f throwing part way through consume_all
+		auto counted = std::make_shared<int>(0);
+		spsc_ring<std::shared_ptr<int>> ring(8);
+		for(int i = 0; i < 4; ++i) {
+			ring.try_push(counted);
+		}
+
+		int calls = 0;
+		bool threw = false;
+		try {
+			ring.consume_all([&](std::shared_ptr<int>&&) {
+				if(++calls == 2) {
+					throw 0;
+				}
+			});
+		} catch(int) {
+			threw = true;
+		}
+		assert((threw && ring.size() == 2 && counted.use_count() == 3) && "values up to the throw should be popped");
+
+		int rest = 0;
+		assert((ring.consume_all([&](std::shared_ptr<int>&& val) { rest += val == counted; }) == 2 && rest == 2) && "the rest should still be intact");
+		assert((counted.use_count() == 1 && ring.empty()) && "every value destroyed once");
+	}
+	{
+		const long total = 100000;
+		spsc_ring<long> ring(64);
+
+		std::thread producer([&] {
+			for(long i = 0; i < total; ++i) {
+				while(!ring.try_push(i)) {
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		long expected = 0;
+		while(expected < total) {
+			long val;
+			if(ring.try_pop(val)) {
+				assert((val == expected) && "values should arrive in push order");
+				++expected;
+			} else {
+				std::this_thread::yield();
+			}
+		}
+		producer.join();
+	}
+}
@@ -0,0 +1,86 @@
+#include "include/work_stealing_ring.hpp"
+
+/*
+ * check owner push/pop and stealing, alone and with concurrent thieves,
+ * including growth while thieves are stealing
+ */
+
+#include <atomic>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+int main()
+{
+	{
+		work_stealing_ring<int> ws(4);
+		int val = 0;
+
+		assert((!ws.pop(val) && !ws.steal(val)) && "empty ring");
+
+		for(int i = 0; i < 10; ++i) {
+			ws.push(i);
+		}
+
+		assert((ws.size() == 10 && ws.capacity() == 16) && "push should grow");
+		assert((ws.pop(val) && val == 9) && "pop takes the most recent");
+		assert((ws.steal(val) && val == 0) && "steal takes the oldest");
+		assert((ws.steal(val) && val == 1) && "steal takes the oldest");
+
+		for(int i = 8; i >= 2; --i) {
+			assert((ws.pop(val) && val == i) && "pop in reverse order");
+		}
+		assert((ws.empty() && !ws.pop(val)) && "popped everything");
+	}
+	{
+		// every value is taken exactly once, with thieves racing the owner
+		const int count = 200000;
+		const int thieves = 3;
+
+		work_stealing_ring<int> ws(2);
+		std::vector<std::atomic<int>> seen(count);
+		for(auto& s : seen) {
+			s.store(0);
+		}
+		std::atomic<bool> done(false);
+		std::atomic<int> taken(0);
+
+		std::vector<std::thread> threads;
+		for(int i = 0; i < thieves; ++i) {
+			threads.emplace_back([&] {
+				int val;
+				while(!done.load()) {
+					if(ws.steal(val)) {
+						seen[static_cast<std::size_t>(val)].fetch_add(1);
+						taken.fetch_add(1);
+					}
+				}
+			});
+		}
+
+		int val;
+		for(int i = 0; i < count; ++i) {
+			ws.push(i);
+			// pop some, so the owner races thieves at the bottom
+			if(i % 3 == 0 && ws.pop(val)) {
+				seen[static_cast<std::size_t>(val)].fetch_add(1);
+				taken.fetch_add(1);
+			}
+		}
+		while(ws.pop(val)) {
+			seen[static_cast<std::size_t>(val)].fetch_add(1);
+			taken.fetch_add(1);
+		}
+		while(taken.load() < count) {
+		}
+
+		done.store(true);
+		for(auto& t : threads) {
+			t.join();
+		}
+
+		for(auto& s : seen) {
+			assert((s.load() == 1) && "every value should be taken once");
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#include "include/flight_recorder.hpp"
+
+/*
+ * print a flight_recorder dump, one event per line, as
+ *
+ *     thread <n> <time in ns, relative to the earliest event> <id> <arg> <data>
+ *
+ * usage: flight_decode [dump file], reading stdin if no file is given
+ *
+ * e.g. c++ -std=c++11 -O2 -I. tools/flight_decode.cpp -o flight_decode
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct thread_events
+{
+	std::uint64_t thread;
+	std::vector<flight_event> events;
+};
+
+bool read_exact(std::FILE* in, void* out, std::size_t size)
+{
+	return std::fread(out, 1, size, in) == size;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	std::FILE* in = stdin;
+	if(argc > 1) {
+		in = std::fopen(argv[1], "rb");
+		if(in == nullptr) {
+			std::perror(argv[1]);
+			return 1;
+		}
+	}
+
+	flight_recorder_detail::file_header file;
+	if(!read_exact(in, &file, sizeof(file)) || std::memcmp(file.magic, "FLRC", 4) != 0) {
+		std::fprintf(stderr, "not a flight recorder dump\n");
+		return 1;
+	}
+	if(file.event_size != sizeof(flight_event)) {
+		std::fprintf(stderr, "events are %" PRIu32 " bytes, expected %zu\n", file.event_size, sizeof(flight_event));
+		return 1;
+	}
+
+	std::vector<thread_events> threads;
+	std::uint64_t earliest = UINT64_MAX;
+
+	flight_recorder_detail::thread_header hdr;
+	while(read_exact(in, &hdr, sizeof(hdr))) {
+		thread_events te;
+		te.thread = hdr.thread;
+		te.events.resize(hdr.count);
+		if(hdr.count > 0 && !read_exact(in, te.events.data(), hdr.count * sizeof(flight_event))) {
+			// a crash dump may be cut short, keep what there is
+			std::fprintf(stderr, "thread %" PRIu64 ": dump cut short\n", hdr.thread);
+			break;
+		}
+		if(!te.events.empty() && te.events.front().time < earliest) {
+			earliest = te.events.front().time;
+		}
+		threads.push_back(std::move(te));
+	}
+
+	for(const auto& te : threads) {
+		for(const auto& ev : te.events) {
+			std::printf("thread %" PRIu64 " %12" PRIu64 " %" PRIu32 " %" PRIu32 " %" PRIu64 "\n",
+				te.thread, ev.time - earliest, ev.id, ev.arg, ev.data);
+		}
+	}
+}